@@ -0,0 +1,78 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+/**
+=================================================== \n
+======================= Scheduler ====================== \n
+===================================================
+*/
+
+// Only depends on <stdint.h>, so the deadline and sleep logic can be compiled and checked on a computer
+// with a simulated clock, e.g. one that starts just before the millisecond counter overflows.
+
+// -- Time source --
+// Returns the time in ms, 'millis()' on the Arduino. Defined in main.cpp, a simulation defines its own one
+typedef uint32_t (*timeSource)();
+extern timeSource schedulerTime;
+
+// -- Deadlines --
+// Deadlines are compared through the signed difference of two 32 bit times, so they keep working when the
+// millisecond counter overflows after 49.7 days. A deadline must not be more than 24.8 days away.
+
+// True once 'now' is at or after 'deadline'
+inline bool deadlinePassed(uint32_t now, uint32_t deadline) {
+    return (int32_t)(now - deadline) >= 0;
+}
+
+// Time left until 'deadline', 0 once it has passed
+inline uint32_t timeUntil(uint32_t now, uint32_t deadline) {
+    return deadlinePassed(now, deadline) ? 0 : deadline - now;
+}
+
+// Of two deadlines, the one that comes first
+inline uint32_t earliestDeadline(uint32_t now, uint32_t deadline1, uint32_t deadline2) {
+    return timeUntil(now, deadline1) <= timeUntil(now, deadline2) ? deadline1 : deadline2;
+}
+
+// -- Same as above, using the time source --
+inline uint32_t deadlineIn(uint32_t delay) {
+    return schedulerTime() + delay;
+}
+
+inline bool deadlineReached(uint32_t deadline) {
+    return deadlinePassed(schedulerTime(), deadline);
+}
+
+inline uint32_t timeLeft(uint32_t deadline) {
+    return timeUntil(schedulerTime(), deadline);
+}
+
+// -- Minutes to ms --
+// Computed in 32 bits, an int overflows after 32 s on the AVR
+inline uint32_t minutesToMs(uint16_t minutes) {
+    return minutes * 60000UL;
+}
+
+// -- Watchdog sleep periods --
+// The watchdog wakes the MCU up after 16 ms << prescaler, with a prescaler from 0 (16 ms) to 9 (8 s).
+// Its oscillator is only accurate to about 10 %, so the slept time is corrected by the next clock sync
+#define watchdogMaxPrescaler 9
+#define noWatchdogPeriod -1
+
+inline uint16_t watchdogPeriod(int8_t prescaler) {
+    return 16U << prescaler;
+}
+
+// Prescaler of the longest watchdog period that ends before 'sleepTime' (in ms),
+// 'noWatchdogPeriod' if even the shortest one is too long
+inline int8_t watchdogPrescaler(uint32_t sleepTime) {
+    int8_t prescaler = noWatchdogPeriod;
+    while (prescaler < watchdogMaxPrescaler && watchdogPeriod(prescaler + 1) <= sleepTime) {
+        prescaler++;
+    }
+    return prescaler;
+}
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <stdint.h>
+
+/**
+=================================================== \n
+====================== Statistics ===================== \n
+===================================================
+*/
+
+// Only depends on <stdint.h>, like the scheduler, so it can be checked on a computer against a float reference.
+// Integer math only : the firmware has no float code, see FORCED_CLIMATE_FIXED_POINT
+
+// -- Running statistics of one channel --
+// The samples are summed as offsets from the first one of the window, and their squares too, exactly in 32 bits,
+// so nothing is rounded until the mean and deviation are read. Rounding a running mean at every sample instead
+// adds up : after a slow drift over a long window it is tens of units off. 64 bit sums would take no bounds but
+// pull the 64 bit multiply, divide and shift routines into the image.
+// The bounds keep the sum of squares below 2^32 : 1024 * 2047^2 = 4290774016.
+// Samples must stay within +/- 2^30, a window holds at most 'statisticsMaxCount' of them and further ones are ignored.
+// Offsets beyond +/- 'statisticsMaxOffset' are summed as the bound, only the minimum and maximum keep them exactly
+#define statisticsMaxCount 1024
+#define statisticsMaxOffset 2047
+
+struct runningStatistics {
+    uint16_t count;         // Samples since the last 'clearStatistics()', stops at 'statisticsMaxCount'
+    int32_t reference;      // First sample of the window
+    int32_t minimum;
+    int32_t maximum;
+    int32_t sum;            // Sum of the offsets from 'reference'
+    uint32_t squares;       // Sum of the squared offsets
+};
+
+inline void clearStatistics(runningStatistics& statistics) {
+    statistics.count = 0;
+    statistics.reference = 0;
+    statistics.minimum = 0;
+    statistics.maximum = 0;
+    statistics.sum = 0;
+    statistics.squares = 0;
+}
+
+inline void addSample(runningStatistics& statistics, int32_t value) {
+    if (statistics.count == 0) {
+        statistics.reference = value;
+        statistics.minimum = value;
+        statistics.maximum = value;
+    }
+    else if (statistics.count == statisticsMaxCount) {
+        return;
+    }
+
+    statistics.count++;
+    if (value < statistics.minimum) {
+        statistics.minimum = value;
+    }
+    if (value > statistics.maximum) {
+        statistics.maximum = value;
+    }
+
+    int32_t offset = value - statistics.reference;
+    if (offset > statisticsMaxOffset) {
+        offset = statisticsMaxOffset;
+    }
+    if (offset < -statisticsMaxOffset) {
+        offset = -statisticsMaxOffset;
+    }
+    statistics.sum += offset;
+    statistics.squares += (uint32_t)(offset * offset);
+}
+
+// Divides 'sum' by 'count' rounded down, 'remainder' gets what is left (0 to count - 1)
+inline int32_t floorDivide(int32_t sum, uint16_t count, uint16_t& remainder) {
+    int32_t quotient = sum / (int32_t)count;
+    int32_t left = sum - quotient * count;
+    if (left < 0) {
+        quotient--;
+        left += count;
+    }
+    remainder = left;
+    return quotient;
+}
+
+// Mean in the channel's unit, rounded to the nearest integer, halves up
+inline int32_t statisticsMean(const runningStatistics& statistics) {
+    uint16_t remainder;
+    int32_t mean = floorDivide(statistics.sum, statistics.count, remainder);
+    mean += statistics.reference;
+    return 2UL * remainder >= statistics.count ? mean + 1 : mean;
+}
+
+// Integer square root, rounded down
+inline uint16_t squareRoot(uint32_t value) {
+    uint32_t root = 0;
+    uint32_t bit = (uint32_t)1 << 30;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+// Sample standard deviation in the channel's unit, rounded to the nearest integer, 0 with less than 2 samples
+inline uint32_t statisticsDeviation(const runningStatistics& statistics) {
+    if (statistics.count < 2) {
+        return 0;
+    }
+
+    // The sum of squared deviations is 'squares' - sum^2 / count. With sum = quotient * count + remainder,
+    // sum^2 / count = quotient^2 * count + 2 * quotient * remainder + remainder^2 / count. It is at most 'squares',
+    // so the terms are added modulo 2^32 and only the result has to fit
+    uint16_t remainder;
+    int32_t quotient = floorDivide(statistics.sum, statistics.count, remainder);
+    uint32_t squaredSum = (uint32_t)(quotient * quotient) * statistics.count + (uint32_t)(2 * quotient * remainder)
+                          + (uint32_t)remainder * remainder / statistics.count;
+    uint32_t deviations = statistics.squares - squaredSum;
+
+    // round(sqrt(v)) = (floor(sqrt(4 v)) + 1) / 2, with 4 v = 4 deviations / (count - 1) rounded down.
+    // The deviations are at most count * 2047^2, so 4 v stays below 8 * 2047^2
+    uint16_t divisor = statistics.count - 1;
+    uint32_t variance4 = deviations / divisor * 4 + deviations % divisor * 4 / divisor;
+    return (squareRoot(variance4) + 1) / 2;
+}
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef SWINGING_DOOR_H
+#define SWINGING_DOOR_H
+
+#include <stdint.h>
+
+/**
+=================================================== \n
+===================== Swinging door ==================== \n
+===================================================
+*/
+
+// Only depends on <stdint.h>, like the scheduler, so the compression can be checked on a computer
+// against the linear reconstruction of 'tools/reconstructLog.py'.
+
+// -- Swinging door --
+// The door of a record is the range of slopes from it whose line passes within a deviation of every reading
+// since. The slopes are kept as a rise over a run (in s), so no division is needed to compare them.
+// A reading is only within the deviation of the line to the next record if that record lies on the door too,
+// which the reading itself does not have to : 'riseOnDoor()' moves it there before it is written.
+// The slopes are compared in 32 bits, so the operands are bounded : rises within +/- 'doorMaxRise', deviations up to
+// 'doorMaxDeviation' and runs up to 'doorMaxRun'. The door rises then stay within +/- 16638, and every cross product
+// within 16638 * 65535 = 1090371330 < 2^31. A reading beyond the bounds closes the door, so it is written as read
+#define doorMaxRise 16383
+#define doorMaxDeviation 255
+#define doorMaxRun 65535
+
+struct swingingDoor {
+    bool open;                          // False until a reading after the record narrowed the door
+    int32_t upperRise;
+    uint16_t upperRun;
+    int32_t lowerRise;
+    uint16_t lowerRun;
+};
+
+// True if the slope riseA / runA is below riseB / runB, runs are never 0
+inline bool slopeBelow(int32_t riseA, uint16_t runA, int32_t riseB, uint16_t runB) {
+    return riseA * (int32_t)runB < riseB * (int32_t)runA;
+}
+
+// -- Narrows 'door' to a reading 'rise' above the record, 'run' s after it --
+// Returns false, leaving the door unchanged, if the reading closes it or is beyond the bounds
+inline bool narrowDoor(swingingDoor& door, int32_t rise, uint32_t run, int32_t deviation) {
+    if (rise > doorMaxRise || rise < -doorMaxRise || run > doorMaxRun || deviation > doorMaxDeviation) {
+        return false;
+    }
+
+    swingingDoor narrowed = door;
+    if (!door.open || slopeBelow(rise + deviation, run, door.upperRise, door.upperRun)) {
+        narrowed.upperRise = rise + deviation;
+        narrowed.upperRun = run;
+    }
+    if (!door.open || slopeBelow(door.lowerRise, door.lowerRun, rise - deviation, run)) {
+        narrowed.lowerRise = rise - deviation;
+        narrowed.lowerRun = run;
+    }
+    narrowed.open = true;
+
+    if (slopeBelow(narrowed.upperRise, narrowed.upperRun, narrowed.lowerRise, narrowed.lowerRun)) {
+        return false;
+    }
+    door = narrowed;
+    return true;
+}
+
+// Rise of the slope 'rise / run' after 'atRun' s, rounded down or up
+inline int32_t riseAfter(int32_t rise, uint16_t run, uint16_t atRun, bool roundUp) {
+    int32_t product = rise * (int32_t)atRun;
+    int32_t quotient = product / (int32_t)run;
+    int32_t rest = product % (int32_t)run;
+    if (rest != 0 && (rest > 0) == roundUp) {
+        quotient += roundUp ? 1 : -1;
+    }
+    return quotient;
+}
+
+// -- Closest rise to 'rise' on the door, 'run' s after the record --
+// Rounded inwards to whole units. Where the door is narrower than one unit, the line may pass up to
+// one unit further than the deviation from the readings. Runs beyond the bounds are left as read
+inline int32_t riseOnDoor(const swingingDoor& door, int32_t rise, uint32_t run) {
+    if (!door.open || run > doorMaxRun) {
+        return rise;
+    }
+
+    int32_t upper = riseAfter(door.upperRise, door.upperRun, run, false);
+    int32_t lower = riseAfter(door.lowerRise, door.lowerRun, run, true);
+    if (rise > upper) {
+        rise = upper;
+    }
+    if (rise < lower) {
+        rise = lower;
+    }
+    return rise;
+}
+
+#endif
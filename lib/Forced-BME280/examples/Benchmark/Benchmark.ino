@@ -0,0 +1,84 @@
+
+/* Forced-BME280 Library
+   Benchmark of the float and the fixed point (FORCED_CLIMATE_FIXED_POINT) compensation paths.
+
+   Build once with and once without -D FORCED_CLIMATE_FIXED_POINT and compare the results.
+   The compensation of the three values is timed on raw readings fetched beforehand, without any I2C transfer.
+   Cycles are counted with Timer1 running at the CPU clock, so this only runs on AVR targets.
+*/
+
+#include <forcedClimate.h>
+
+ForcedClimate climateSensor = ForcedClimate();
+
+// Discards everything printed to it, used to time the text conversion without the serial output
+class NullPrint : public Print {
+	public:
+		size_t write(uint8_t) override { return 1; }
+} nullPrint;
+
+const uint8_t runs = 32;
+
+void startCycleCounter(){
+	TCCR1A = 0;
+	TCCR1B = 0;
+	TCNT1 = 0;
+	TCCR1B = 1 << CS10;		// No prescaler, one count per CPU cycle
+}
+
+uint16_t readCycleCounter(){
+	return TCNT1;
+}
+
+void printResult(const char * name, uint32_t cycles){
+	Serial.print(name);
+	Serial.print(": ");
+	Serial.print(cycles / runs);
+	Serial.println(" cycles");
+}
+
+void setup(){
+	Serial.begin(9600);
+	climateSensor.begin();
+
+	#ifdef FORCED_CLIMATE_INTEGER
+	Serial.println("Fixed point compensation");
+	#else
+	Serial.println("Float compensation");
+	#endif
+}
+
+void loop(){
+	uint32_t compensationCycles = 0, printCycles = 0;
+
+	// The registers are read once, only the compensation math of both paths is timed
+	climateSensor.takeForcedMeasurement();
+	delay(10);
+	int32_t temperatureAdc, pressureAdc, humidityAdc;
+	climateSensor.getRawData(temperatureAdc, pressureAdc, humidityAdc);
+
+	for (uint8_t i = 0; i < runs; i++){
+		#ifdef FORCED_CLIMATE_INTEGER
+		int32_t temperature;
+		uint32_t pressure, humidity;
+		#else
+		float temperature, pressure, humidity;
+		#endif
+
+		startCycleCounter();
+		climateSensor.compensate(temperatureAdc, pressureAdc, humidityAdc, temperature, pressure, humidity);
+		compensationCycles += readCycleCounter();
+
+		// Conversion of the three values to text
+		startCycleCounter();
+		nullPrint.print(temperature);
+		nullPrint.print(humidity);
+		nullPrint.print(pressure);
+		printCycles += readCycleCounter();
+	}
+
+	printResult("Compensation", compensationCycles);
+	printResult("Text conversion", printCycles);
+	Serial.println();
+	delay(5000);
+}
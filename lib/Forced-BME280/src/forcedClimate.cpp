@@ -38,7 +38,11 @@ ForcedClimate::ForcedClimate(USI_TWI & bus, const uint8_t address, const bool au
 ForcedClimate::ForcedClimate(TwoWire & bus, const uint8_t address, const bool autoBegin):   
 #endif
     bus(bus),
-    address(address)
+    address(address),
+    ctrlHum(0b00000001),
+    ctrlMeas(0b00100101),
+    config(0b00000000),
+    samplingChanged(false)
 {
     if(autoBegin){
         bus.begin();
@@ -60,32 +64,84 @@ void ForcedClimate::begin(){
     readCalibrationData();
 }
 
+/// \brief
+/// Set sampling
+/// \details
+/// This sets the oversampling of temperature, pressure and humidity and the
+/// IIR filter coefficient, both given as register values:
+/// oversampling 1 = x1, 2 = x2, 3 = x4, 4 = x8, 5 = x16 and
+/// filter 0 = off, 1 = 2, 2 = 4, 3 = 8, 4 = 16.
+/// Higher values give less noisy readings but longer conversions. The new
+/// settings are written to the chip at the start of the next measurement,
+/// so this may be called before begin().
+void ForcedClimate::setSampling(const uint8_t oversampling, const uint8_t filter){
+    uint8_t osrs = oversampling & 0b111;
+    ctrlHum = osrs;
+    ctrlMeas = osrs << 5 | osrs << 2 | 0b01;        // Last two bits are 01 for forced systemMode
+    config = (filter & 0b111) << 2;
+    samplingChanged = true;
+}
+
 /// \brief
 /// Take forced measurement
 /// \details
 /// This function takes a forced measurement. That is, the BME280 is woken up to take
 /// a measurement after which it goes back to sleep. During this sleep, it consumes
-/// 0.25uA!
+/// 0.25uA! This function waits until the measurement is done.
 void ForcedClimate::takeForcedMeasurement(){
+    startMeasurement();
+    while(!measurementReady()){
+        delay(2);
+    }
+}
+
+/// \brief
+/// Start measurement
+/// \details
+/// This function starts a forced measurement and returns immediately. Use
+/// measurementReady() to know when the results can be collected, so other
+/// work can be done during the conversion.
+void ForcedClimate::startMeasurement(){
+    if(samplingChanged){
+        applyOversamplingControls();
+    }
     bus.beginTransmission(address);
     bus.write((uint8_t)registers::CTRL_MEAS);
-    bus.write(0b00100101);
+    bus.write(ctrlMeas);
+    bus.endTransmission();
+}
+
+/// \brief
+/// Measurement ready
+/// \details
+/// This function returns true once the conversion started by startMeasurement()
+/// is done, that is when the measuring bit of the status register is cleared.
+bool ForcedClimate::measurementReady(){
+    bus.beginTransmission(address);
+    bus.write((uint8_t)registers::STATUS);
     bus.endTransmission();
+    bus.requestFrom(address, (uint8_t)1);
+    return !(bus.read() & 0b00001000);
 }
 
 /// \brief
 /// Apply oversampling controls
 /// \details
-/// This function sets the sampling controls to values that are
-/// suitable for all kinds of applications.
+/// This function writes the sampling controls set by setSampling(). The
+/// defaults (x1 oversampling, filter off) are suitable for all kinds of applications.
+/// CTRL_MEAS is written in sleep systemMode, which also makes the new CTRL_HUM
+/// effective, so only startMeasurement() starts a conversion.
 void ForcedClimate::applyOversamplingControls(){
     bus.beginTransmission(address);
     bus.write((uint8_t)registers::CTRL_HUM);
-    bus.write(0b00000001);
+    bus.write(ctrlHum);
+    bus.write((uint8_t)registers::CONFIG);
+    bus.write(config);
     bus.write((uint8_t)registers::CTRL_MEAS);
-    bus.write(0b00100101);                          // Last two bits are 01 for forced, 11 for normal and 00 for sleep systemMode
+    bus.write(ctrlMeas & 0b11111100);               // Last two bits are 01 for forced, 11 for normal and 00 for sleep systemMode
     bus.write((uint8_t)registers::FIRST_CALIB);
     bus.endTransmission();
+    samplingChanged = false;
 }
 
 /// \brief
@@ -118,7 +174,7 @@ void ForcedClimate::readCalibrationData(){
 /// \details
 /// This function retrieves the compensated temperature as described
 /// on page 50 of the BME280 Datasheet.
-#ifdef FORCED_CLIMATE_ATTINY
+#ifdef FORCED_CLIMATE_INTEGER
 int32_t ForcedClimate::getTemperatureCelcius(const bool performMeasurement)
 #else
 float ForcedClimate::getTemperatureCelcius(const bool performMeasurement)
@@ -127,30 +183,38 @@ float ForcedClimate::getTemperatureCelcius(const bool performMeasurement)
     bus.beginTransmission(address);
     if(performMeasurement){
         bus.write((uint8_t)registers::CTRL_MEAS);
-        bus.write(0b00100101);
+        bus.write(ctrlMeas);
     }
     bus.write((uint8_t)registers::TEMP_MSB);
     bus.endTransmission();
     bus.requestFrom(address, (uint8_t)3);
-    int32_t adc = readFourRegisters();
-    int32_t var1 = ((((adc>>3) - ((int32_t)((uint16_t)temperature[1])<<1))) * ((int32_t)temperature[2])) >> 11;
-    int32_t var2 = ((((adc>>4) - ((int32_t)((uint16_t)temperature[1]))) * ((adc>>4) - ((int32_t)((uint16_t)temperature[1])))) >> 12);
-    var2 = (var2 * ((int32_t)temperature[3])) >> 14;
-    BME280t_fine = var1 + var2;
-    int32_t temperature = (BME280t_fine*5+128)>>8;
-    #ifdef FORCED_CLIMATE_ATTINY
+    int32_t temperature = compensateTemperature(readFourRegisters());
+    #ifdef FORCED_CLIMATE_INTEGER
     return temperature;
     #else
     return float(temperature / 100.0);
     #endif
 }
 
+/// \brief
+/// Compensate Temperature
+/// \details
+/// This function converts a raw temperature reading to 1/100 °C as described
+/// on page 50 of the BME280 Datasheet and updates BME280t_fine.
+int32_t ForcedClimate::compensateTemperature(const int32_t adc){
+    int32_t var1 = ((((adc>>3) - ((int32_t)((uint16_t)temperature[1])<<1))) * ((int32_t)temperature[2])) >> 11;
+    int32_t var2 = ((((adc>>4) - ((int32_t)((uint16_t)temperature[1]))) * ((adc>>4) - ((int32_t)((uint16_t)temperature[1])))) >> 12);
+    var2 = (var2 * ((int32_t)temperature[3])) >> 14;
+    BME280t_fine = var1 + var2;
+    return (BME280t_fine*5+128)>>8;
+}
+
 /// \brief
 /// Get Pressure
 /// \details
 /// This function retrieves the compensated pressure as described
 /// on page 50 of the BME280 Datasheet.
-#ifdef FORCED_CLIMATE_ATTINY
+#ifdef FORCED_CLIMATE_INTEGER
 uint32_t ForcedClimate::getPressure(const bool performMeasurement)
 #else
 float ForcedClimate::getPressure(const bool performMeasurement)
@@ -159,13 +223,25 @@ float ForcedClimate::getPressure(const bool performMeasurement)
     bus.beginTransmission(address);
     if(performMeasurement){
         bus.write((uint8_t)registers::CTRL_MEAS);
-        bus.write(0b00100101);
+        bus.write(ctrlMeas);
     }
     bus.write((uint8_t)registers::PRESS_MSB);
     bus.endTransmission();
     bus.requestFrom(address, (uint8_t)3);
+    uint32_t p = compensatePressure(readFourRegisters());
+    #ifdef FORCED_CLIMATE_INTEGER
+    return p;
+    #else
+    return float(p / 100.0);
+    #endif
+}
 
-    int32_t adc = readFourRegisters();
+/// \brief
+/// Compensate Pressure
+/// \details
+/// This function converts a raw pressure reading to Pa as described
+/// on page 50 of the BME280 Datasheet. BME280t_fine has to be up to date.
+uint32_t ForcedClimate::compensatePressure(const int32_t adc){
     int32_t var1 = (((int32_t)BME280t_fine)>>1) - (int32_t)64000;
     int32_t var2 = (((var1>>2) * (var1>>2)) >> 11 ) * ((int32_t)pressure[6]);
     var2 = var2 + ((var1*((int32_t)pressure[5]))<<1);
@@ -186,11 +262,7 @@ float ForcedClimate::getPressure(const bool performMeasurement)
     var1 = (((int32_t)pressure[9]) * ((int32_t)(((p>>3) * (p>>3))>>13)))>>12;
     var2 = (((int32_t)(p>>2)) * ((int32_t)pressure[8]))>>13;
     p = (uint32_t)((int32_t)p + ((var1 + var2 + pressure[7]) >> 4));
-    #ifdef FORCED_CLIMATE_ATTINY
     return p;
-    #else
-    return float(p / 100.0);
-    #endif
 }
 
 /// \brief
@@ -198,7 +270,7 @@ float ForcedClimate::getPressure(const bool performMeasurement)
 /// \details
 /// This function retrieves the compensated humidity as described
 /// on page 50 of the BME280 Datasheet.
-#ifdef FORCED_CLIMATE_ATTINY
+#ifdef FORCED_CLIMATE_INTEGER
 uint32_t ForcedClimate::getRelativeHumidity(const bool performMeasurement)
 #else
 float ForcedClimate::getRelativeHumidity(const bool performMeasurement)
@@ -207,13 +279,26 @@ float ForcedClimate::getRelativeHumidity(const bool performMeasurement)
     bus.beginTransmission(address);
     if(performMeasurement){
         bus.write((uint8_t)registers::CTRL_MEAS);
-        bus.write(0b00100101);
+        bus.write(ctrlMeas);
     }
     bus.write((uint8_t)registers::HUM_MSB);
     bus.endTransmission();
     bus.requestFrom(address, (uint8_t)2);
     uint8_t hi = bus.read(); uint8_t lo = bus.read();
-    int32_t adc = (uint16_t)(hi<<8 | lo);
+    uint32_t humidity = compensateHumidity((uint16_t)(hi<<8 | lo));
+    #ifdef FORCED_CLIMATE_INTEGER
+    return humidity;
+    #else
+    return float(humidity / 100.0);
+    #endif
+}
+
+/// \brief
+/// Compensate Humidity
+/// \details
+/// This function converts a raw humidity reading to 1/100 % as described
+/// on page 50 of the BME280 Datasheet. BME280t_fine has to be up to date.
+uint32_t ForcedClimate::compensateHumidity(const int32_t adc){
     int32_t var1;
     var1 = (BME280t_fine - ((int32_t)76800));
     var1 = (((((adc << 14) - (((int32_t)humidity[4]) << 20) - (((int32_t)humidity[5]) * var1)) +
@@ -223,10 +308,67 @@ float ForcedClimate::getRelativeHumidity(const bool performMeasurement)
     var1 = (var1 - (((((var1 >> 15) * (var1 >> 15)) >> 7) * ((int32_t)humidity[1])) >> 4));
     var1 = (var1 < 0 ? 0 : var1);
     var1 = (var1 > 419430400 ? 419430400 : var1);
-    uint32_t humidity = (uint32_t)((var1>>12)*25)>>8;
-    #ifdef FORCED_CLIMATE_ATTINY
-    return humidity;
+    return (uint32_t)((var1>>12)*25)>>8;
+}
+
+/// \brief
+/// Get Raw Data
+/// \details
+/// This function retrieves the uncompensated temperature, pressure and humidity readings.
+/// All data registers (0xF7 to 0xFE) are read in a single I2C transfer.
+void ForcedClimate::getRawData(int32_t & temperatureAdc, int32_t & pressureAdc, int32_t & humidityAdc, const bool performMeasurement){
+    bus.beginTransmission(address);
+    if(performMeasurement){
+        bus.write((uint8_t)registers::CTRL_MEAS);
+        bus.write(ctrlMeas);
+    }
+    bus.write((uint8_t)registers::PRESS_MSB);
+    bus.endTransmission();
+    bus.requestFrom(address, (uint8_t)8);
+
+    // Registers are read in order : pressure, temperature and humidity
+    pressureAdc = readFourRegisters();
+    temperatureAdc = readFourRegisters();
+    uint8_t hi = bus.read(); uint8_t lo = bus.read();
+    humidityAdc = (uint16_t)(hi<<8 | lo);
+}
+
+/// \brief
+/// Compensate
+/// \details
+/// This function converts readings retrieved by getRawData() to the compensated
+/// temperature, pressure and humidity, without any I2C transfer.
+#ifdef FORCED_CLIMATE_INTEGER
+void ForcedClimate::compensate(const int32_t temperatureAdc, const int32_t pressureAdc, const int32_t humidityAdc, int32_t & temperature, uint32_t & pressure, uint32_t & humidity)
+#else
+void ForcedClimate::compensate(const int32_t temperatureAdc, const int32_t pressureAdc, const int32_t humidityAdc, float & temperature, float & pressure, float & humidity)
+#endif
+{
+    // Temperature has to be compensated first, as it updates BME280t_fine
+    #ifdef FORCED_CLIMATE_INTEGER
+    temperature = compensateTemperature(temperatureAdc);
+    pressure = compensatePressure(pressureAdc);
+    humidity = compensateHumidity(humidityAdc);
     #else
-    return float(humidity / 100.0);
+    temperature = float(compensateTemperature(temperatureAdc) / 100.0);
+    pressure = float(compensatePressure(pressureAdc) / 100.0);
+    humidity = float(compensateHumidity(humidityAdc) / 100.0);
     #endif
 }
+
+/// \brief
+/// Get All
+/// \details
+/// This function retrieves the compensated temperature, pressure and humidity.
+/// All data registers are read in a single I2C transfer, so this is
+/// much faster than calling the three separate functions.
+#ifdef FORCED_CLIMATE_INTEGER
+void ForcedClimate::getAll(int32_t & temperature, uint32_t & pressure, uint32_t & humidity, const bool performMeasurement)
+#else
+void ForcedClimate::getAll(float & temperature, float & pressure, float & humidity, const bool performMeasurement)
+#endif
+{
+    int32_t temperatureAdc, pressureAdc, humidityAdc;
+    getRawData(temperatureAdc, pressureAdc, humidityAdc, performMeasurement);
+    compensate(temperatureAdc, pressureAdc, humidityAdc, temperature, pressure, humidity);
+}
@@ -0,0 +1,123 @@
+
+/* Forced-BME280 Library
+   Jochem van Kranenburg - jochemvk.duckdns.org - 9 March 2020
+*/
+
+#ifndef __FORCED_CLIMATE_HPP
+#define __FORCED_CLIMATE_HPP
+
+#if defined(__AVR_ATtiny25__) | defined(__AVR_ATtiny45__) | defined(__AVR_ATtiny85__) | defined(__AVR_AT90Tiny26__) | defined(__AVR_ATtiny26__)
+	#define FORCED_CLIMATE_ATTINY
+#endif
+
+// Define FORCED_CLIMATE_FIXED_POINT (e.g. as a build flag) to use the integer results on any target.
+// Temperature is then returned in 1/100 °C, pressure in Pa and humidity in 1/100 %, which
+// avoids soft-float math on targets without an FPU.
+#if defined(FORCED_CLIMATE_ATTINY) | defined(FORCED_CLIMATE_FIXED_POINT)
+	#define FORCED_CLIMATE_INTEGER
+#endif
+
+#include <Arduino.h>
+
+#ifdef FORCED_CLIMATE_ATTINY
+#include <TinyWireM.h>
+#else
+#include <Wire.h>
+#endif 
+
+class ForcedClimate {
+	private:
+		#ifdef FORCED_CLIMATE_ATTINY
+		USI_TWI & bus;
+		#else
+		TwoWire & bus;	
+		#endif
+		uint8_t address;
+
+		int16_t temperature[4];
+		int16_t pressure[10];
+		int16_t humidity[7];
+		int32_t BME280t_fine;
+
+		uint8_t ctrlHum;
+		uint8_t ctrlMeas;
+		uint8_t config;
+		bool samplingChanged;
+
+		int16_t readTwoRegisters();
+		int32_t readFourRegisters();
+
+		void applyOversamplingControls();
+		void readCalibrationData();
+
+		int32_t compensateTemperature(const int32_t adc);
+		uint32_t compensatePressure(const int32_t adc);
+		uint32_t compensateHumidity(const int32_t adc);
+
+		enum class registers {
+			CTRL_HUM = 0xF2,
+			CTRL_MEAS = 0xF4,
+			CONFIG = 0xF5,
+			FIRST_CALIB = 0x88,
+			SCND_CALIB = 0xE1,
+			TEMP_MSB = 0xFA,
+			HUM_MSB = 0xFD,
+			PRESS_MSB = 0xF7,
+			STATUS = 0xF3
+		};
+
+	public:
+		#ifdef FORCED_CLIMATE_ATTINY
+		ForcedClimate(USI_TWI & bus = TinyWireM, const uint8_t address = 0x76, const bool autoBegin = false);
+		#else
+		ForcedClimate(TwoWire & bus = Wire, const uint8_t address = 0x76, const bool autoBegin = false);	
+		#endif
+
+		void begin();
+		void setSampling(const uint8_t oversampling, const uint8_t filter);
+		void takeForcedMeasurement();
+		void startMeasurement();
+		bool measurementReady();
+
+		#ifdef FORCED_CLIMATE_INTEGER
+		int32_t getTemperatureCelcius(const bool performMeasurement = false);
+		#else
+		float getTemperatureCelcius(const bool performMeasurement = false);
+		#endif
+
+		#ifdef FORCED_CLIMATE_INTEGER
+		uint32_t getPressure(const bool performMeasurement = false);
+		#else
+		float getPressure(const bool performMeasurement = false);
+		#endif
+
+		#ifdef FORCED_CLIMATE_INTEGER
+		uint32_t getRelativeHumidity(const bool performMeasurement = false);
+		#else
+		float getRelativeHumidity(const bool performMeasurement = false);
+		#endif
+
+		#ifdef FORCED_CLIMATE_INTEGER
+		void getAll(int32_t & temperature, uint32_t & pressure, uint32_t & humidity, const bool performMeasurement = false);
+		#else
+		void getAll(float & temperature, float & pressure, float & humidity, const bool performMeasurement = false);
+		#endif
+
+		void getRawData(int32_t & temperatureAdc, int32_t & pressureAdc, int32_t & humidityAdc, const bool performMeasurement = false);
+
+		#ifdef FORCED_CLIMATE_INTEGER
+		void compensate(const int32_t temperatureAdc, const int32_t pressureAdc, const int32_t humidityAdc, int32_t & temperature, uint32_t & pressure, uint32_t & humidity);
+		#else
+		void compensate(const int32_t temperatureAdc, const int32_t pressureAdc, const int32_t humidityAdc, float & temperature, float & pressure, float & humidity);
+		#endif
+
+		#ifdef FORCED_CLIMATE_INTEGER
+		void collect(int32_t & temperature, uint32_t & pressure, uint32_t & humidity){ getAll(temperature, pressure, humidity); }
+		#else
+		void collect(float & temperature, float & pressure, float & humidity){ getAll(temperature, pressure, humidity); }
+		#endif
+
+};
+
+
+#endif //__FORCED_CLIMATE_HPP
@@ -7,6 +7,12 @@
 #include <DS1307.h>
 #include <ChainableLED.h>
 #include <EEPROM.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+
+#include "scheduler.h"
+#include "statistics.h"
+#include "swingingDoor.h"
 
 // -- Pins --
 // GPS - SoftSerial pins
@@ -29,18 +35,35 @@
 
 // -- MISC --
 #define buttonPressTime 5000  // Time button has to be pressed for (in ms)
-#define configTimeout 1800000    // Time no command has to be entered for, to exit config mode (in ms)
+#define configTimeout 1800000UL  // Time no command has to be entered for, to exit config mode (in ms)
+#define stayAwakeTime 10000       // Time power-down is not used after a serial command or a wake-up by a button (in ms)
 
 #define deviceID 69
 #define programVersion 420
 
 
 // -- EEPROM Adresses --
-#define EEPROM_BOOL_programHasRunBefore 1     // Set to true if the program has been executed before, since having been written to the arduino's flash
-#define EEPROM_configuration 2                // Contains the system configuration
+#define EEPROM_BOOL_programHasRunBefore 1     // Set by firmware without config slots, only read to migrate its configuration
+#define EEPROM_legacyConfiguration 2          // Configuration of firmware without config slots
+#define EEPROM_logFile 64                     // Contains the date and revision of the current LOG file
+#define EEPROM_configSlots 128                // First config slot, the slots take up the rest of the EEPROM
 
 DS1307 clock;
 
+// -- Devices found at boot --
+// A missing sensor is logged as N/A instead of stopping the system
+bool RTCpresent = true;
+bool BMEpresent = true;
+bool GPSpresent = true;
+
+// -- Scheduler time source --
+// All deadlines are taken from it, see scheduler.h
+uint32_t boardTime() {
+    return millis();
+}
+
+timeSource schedulerTime = boardTime;
+
 /**
 =================================================== \n
 ====================== LED Stuff ===================== \n
@@ -148,8 +171,41 @@ struct configuration {
     unsigned char LOG_INTERVALL;                    // Intervall between readings (in minutes)
     unsigned int TIMEOUT;                           // Determiner after how much time of a sensor not responding, a Timeout is triggered
     unsigned short int FILE_MAX_SIZE;               // Maximum file size, when reached a new file is created
+    unsigned char LOG_FORMAT;                       // Format of the LOG files, see 'logFormat'
+    unsigned char PREALLOCATE;                      // If 1, new LOG files are preallocated and written sector by sector
+    unsigned char STANDARD_OVERSAMPLING;            // BME280 oversampling in standard and maintenance mode (1, 2, 4, 8 or 16)
+    unsigned char STANDARD_FILTER;                  // BME280 IIR filter coefficient in standard and maintenance mode (0, 2, 4, 8 or 16)
+    unsigned char ECONOMIC_OVERSAMPLING;            // BME280 oversampling in economic mode (1, 2, 4, 8 or 16)
+    unsigned char ECONOMIC_FILTER;                  // BME280 IIR filter coefficient in economic mode (0, 2, 4, 8 or 16)
+    unsigned char GPS_RAW;                          // If 1, the raw GGA sentence is added to text LOG lines
+    unsigned char GPS_SENTENCES;                    // NMEA sentences sent by the GPS, see 'GPSsentence'
+    unsigned int GPS_RATE;                          // Time between two GPS fixes (in ms)
+    unsigned char GPS_STANDBY;                      // GPS standby between readings, see 'GPSstandbyPolicy'
+    unsigned char GPS_WARMUP;                       // Time the GPS is woken up before a reading (in s)
+    unsigned char CLOCK_SYNC;                       // If 1, the RTC is set to the UTC time of the GPS
+    unsigned char POWER_DOWN;                       // If 1, the MCU is powered down between readings when possible
+    unsigned char TENDENCY_FALL;                    // Pressure fall that shortens the LOG interval (in 1/10 hPa per hour), 0 : off
+    unsigned char STATISTICS;                       // If 1, the sensors are sampled every SAMPLE_PERIOD and each record summarizes a LOG interval
+    unsigned char SAMPLE_PERIOD;                    // Time between two samples of the sensors with STATISTICS (in s)
+    unsigned char DEADBAND;                         // If 1, a record is only written once a channel changed, see 'recordChanged()'
+    unsigned char DEADBAND_TEMP;                    // Temperature change that is written with DEADBAND (in 1/10 °C)
+    unsigned char DEADBAND_HYGR;                    // Humidity change that is written with DEADBAND (in 1/10 %)
+    unsigned char DEADBAND_PRESSURE;                // Largest error of the pressure trace with DEADBAND (in Pa)
+    unsigned char DEADBAND_LIGHT;                   // Luminosity change that is written with DEADBAND (raw reading)
+    unsigned char MAX_SILENCE;                      // Longest time without a record with DEADBAND (in minutes)
 } currentSystemConfiguration;
 
+// -- Bits of GPS_SENTENCES, in the order of the PMTK314 fields --
+// Only GGA is used and always enabled, the other sentences are just forwarded to the GPS when enabled
+enum GPSsentence {GLL_sentence = 1, RMC_sentence = 2, VTG_sentence = 4, GGA_sentence = 8, GSA_sentence = 16, GSV_sentence = 32};
+
+// -- Modes in which the GPS is put in standby between readings --
+enum GPSstandbyPolicy {noStandby, economicStandby, alwaysStandby};
+
+// -- Enum containing all supported LOG file formats --
+// Any other value read from EEPROM is treated as textFormat
+enum logFormat {textFormat, binaryFormat};
+
 void defaultConfig() {
     currentSystemConfiguration.ACTIVATE_LUMINOSITY_SENSOR = true;
     currentSystemConfiguration.LUMINOSITY_LOW_THRESHOLD = 255;
@@ -166,22 +222,219 @@ void defaultConfig() {
     currentSystemConfiguration.LOG_INTERVALL = 2;
     currentSystemConfiguration.TIMEOUT = 30000;
     currentSystemConfiguration.FILE_MAX_SIZE = 4096;
+    currentSystemConfiguration.LOG_FORMAT = textFormat;
+    currentSystemConfiguration.PREALLOCATE = 0;
+    currentSystemConfiguration.STANDARD_OVERSAMPLING = 1;
+    currentSystemConfiguration.STANDARD_FILTER = 0;
+    currentSystemConfiguration.ECONOMIC_OVERSAMPLING = 1;
+    currentSystemConfiguration.ECONOMIC_FILTER = 0;
+    currentSystemConfiguration.GPS_RAW = 0;
+    currentSystemConfiguration.GPS_SENTENCES = GGA_sentence;
+    currentSystemConfiguration.GPS_RATE = 1000;
+    currentSystemConfiguration.GPS_STANDBY = economicStandby;
+    currentSystemConfiguration.GPS_WARMUP = 15;
+    currentSystemConfiguration.CLOCK_SYNC = 1;
+    currentSystemConfiguration.POWER_DOWN = 1;
+    currentSystemConfiguration.TENDENCY_FALL = 10;
+    currentSystemConfiguration.STATISTICS = 0;
+    currentSystemConfiguration.SAMPLE_PERIOD = 10;
+    currentSystemConfiguration.DEADBAND = 0;
+    currentSystemConfiguration.DEADBAND_TEMP = 2;
+    currentSystemConfiguration.DEADBAND_HYGR = 10;
+    currentSystemConfiguration.DEADBAND_PRESSURE = 20;
+    currentSystemConfiguration.DEADBAND_LIGHT = 50;
+    currentSystemConfiguration.MAX_SILENCE = 60;
+}
+
+bool binaryLogging() {
+    return currentSystemConfiguration.LOG_FORMAT == binaryFormat;
+}
+
+bool statisticsLogging() {
+    return currentSystemConfiguration.STATISTICS == 1;
+}
+
+bool deadbandLogging() {
+    return currentSystemConfiguration.DEADBAND == 1;
+}
+
+// -- EEPROM writes --
+// An EEPROM byte write takes about 3.3 ms and wears the cell, so only bytes that changed are written
+unsigned int EEPROMupdates = 0;         // Number of calls to 'updateEEPROM()'
+unsigned int EEPROMbytesWritten = 0;    // Number of bytes that actually had to be written
+unsigned long EEPROMwriteTime = 0;      // Total time spent in 'updateEEPROM()' (in µs)
+
+// Writes 'size' bytes of 'data' at 'address', like 'EEPROM.update()' but counting the bytes written
+void updateEEPROM(int address, const void* data, size_t size) {
+    unsigned long start = micros();
+    const unsigned char* bytes = (const unsigned char*)data;
+
+    for (size_t i = 0; i < size; i++) {
+        if (EEPROM.read(address + i) != bytes[i]) {
+            EEPROM.write(address + i, bytes[i]);
+            EEPROMbytesWritten++;
+        }
+    }
+
+    EEPROMupdates++;
+    EEPROMwriteTime += micros() - start;
+}
+
+// Reads 'size' bytes at 'address' into 'data'
+void readEEPROM(int address, void* data, size_t size) {
+    unsigned char* bytes = (unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        bytes[i] = EEPROM.read(address + i);
+    }
 }
 
-// Set to false if this is the first time program is being executed since having been flashed onto the arduino
-// this is being used to determine whether the RTC needs to be set to the correct time and if there is already a
-// config that needs to be loaded from EEPROM
-bool programHasRunBefore = false;
+// True if the 'size' bytes at 'address' hold 'data'
+bool EEPROMholds(int address, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        if (EEPROM.read(address + i) != bytes[i]) {
+            return false;
+        }
+    }
+    return true;
+}
 
 // -- EEPROM Config --
-// Wite currentSystemConfiguration to EEPROM
+// Every save that changes the configuration goes to the next slot with a higher generation, which spreads the wear
+// over the EEPROM. Only the bytes that differ from what that slot held are written : the fields changed since its
+// last use, configSlotCount saves ago, and the CRC and generation. A save that changes nothing writes nothing.
+// A torn write only breaks its own slot, boot then falls back to the previous one
+#define configVersion 1
+#define configSlotSize 64
+#define configSlotCount ((E2END + 1 - EEPROM_configSlots) / configSlotSize)
+
+struct configSlotHeader {
+    uint16_t CRC;           // CRC-16/CCITT of the rest of the slot, up to the end of the configuration
+    uint16_t generation;    // Incremented with every save, the newest valid slot is loaded at boot
+    uint8_t version;        // 'configVersion' of the firmware that wrote the slot
+    uint8_t size;           // sizeof(configuration) of the firmware that wrote the slot
+};
+
+static_assert(sizeof(configSlotHeader) + sizeof(configuration) <= configSlotSize, "configuration does not fit into a config slot");
+
+// Slot and generation of the current configuration
+unsigned char configSlot = 0;
+uint16_t configGeneration = 0;
+
+// -- CRC-16/CCITT --
+uint16_t updateCRC(uint16_t crc, unsigned char data) {
+    crc ^= (uint16_t)data << 8;
+    for (unsigned char i = 0; i < 8; i++) {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+uint16_t updateCRC(uint16_t crc, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        crc = updateCRC(crc, bytes[i]);
+    }
+    return crc;
+}
+
+int configSlotAddress(unsigned char slot) {
+    return EEPROM_configSlots + slot * configSlotSize;
+}
+
+// Header of a slot holding currentSystemConfiguration as 'configGeneration'
+configSlotHeader configHeader() {
+    configSlotHeader header;
+    header.generation = configGeneration;
+    header.version = configVersion;
+    header.size = sizeof(configuration);
+    header.CRC = updateCRC(updateCRC(0xFFFF, &header.generation, sizeof(header) - sizeof(header.CRC)),
+                           &currentSystemConfiguration, sizeof(configuration));
+    return header;
+}
+
+// Wite currentSystemConfiguration to the next slot, unless the current one already holds it
 void writeConfigToEEPROM () {
-    EEPROM.put(EEPROM_configuration, currentSystemConfiguration);
+    configSlotHeader header = configHeader();
+    if (EEPROMholds(configSlotAddress(configSlot), &header, sizeof(header))
+        && EEPROMholds(configSlotAddress(configSlot) + sizeof(header), &currentSystemConfiguration, sizeof(configuration))) {
+        return;
+    }
+
+    configSlot = (configSlot + 1) % configSlotCount;
+    configGeneration++;
+    header = configHeader();
+
+    // The header is written last, so a slot is only valid once its configuration is complete
+    updateEEPROM(configSlotAddress(configSlot) + sizeof(header), &currentSystemConfiguration, sizeof(configuration));
+    updateEEPROM(configSlotAddress(configSlot), &header, sizeof(header));
+}
+
+// -- Fetch the newest valid configuration from EEPROM, write to currentSystemConfiguration --
+// Returns false if no slot is valid. The configuration only ever grows at its end, so a slot written by
+// an older firmware is migrated by keeping the default value of the fields it did not have
+bool getConfigFromEEPROM () {
+    bool found = false;
+    configSlotHeader newest;
+
+    // One pass over all slots
+    for (unsigned char slot = 0; slot < configSlotCount; slot++) {
+        configSlotHeader header;
+        readEEPROM(configSlotAddress(slot), &header, sizeof(header));
+
+        // Erased slots (0xFF) fail here
+        if (header.version == 0 || header.version > configVersion || header.size > configSlotSize - sizeof(header)) {
+            continue;
+        }
+
+        uint16_t CRC = updateCRC(0xFFFF, &header.generation, sizeof(header) - sizeof(header.CRC));
+        for (int address = configSlotAddress(slot) + sizeof(header); address < configSlotAddress(slot) + (int)sizeof(header) + header.size; address++) {
+            CRC = updateCRC(CRC, EEPROM.read(address));
+        }
+        if (CRC != header.CRC) {
+            continue;
+        }
+
+        // Generations wrap around, the newest one is less than half the range ahead
+        if (!found || (int16_t)(header.generation - newest.generation) > 0) {
+            found = true;
+            newest = header;
+            configSlot = slot;
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    configGeneration = newest.generation;
+    defaultConfig();
+    readEEPROM(configSlotAddress(configSlot) + sizeof(newest), &currentSystemConfiguration, min(newest.size, sizeof(configuration)));
+
+    // Written again in the current layout
+    if (newest.version != configVersion || newest.size != sizeof(configuration)) {
+        writeConfigToEEPROM();
+    }
+    return true;
 }
 
-// Fetch configuration from EEPROM, write to currentSystemConfiguration
-void getConfigFromEEPROM () {
-    EEPROM.get(EEPROM_configuration, currentSystemConfiguration);
+// -- Migrates the configuration of firmware without config slots --
+// It only had the fields up to FILE_MAX_SIZE, at a fixed address. Returns false if there is none
+#define legacyConfigurationSize (offsetof(configuration, FILE_MAX_SIZE) + sizeof(currentSystemConfiguration.FILE_MAX_SIZE))
+
+bool migrateLegacyConfig() {
+    if (EEPROM.read(EEPROM_BOOL_programHasRunBefore) != 1) {
+        return false;
+    }
+
+    defaultConfig();
+    readEEPROM(EEPROM_legacyConfiguration, &currentSystemConfiguration, legacyConfigurationSize);
+    writeConfigToEEPROM();
+
+    // Never migrated again, even if all slots were to be corrupted
+    const unsigned char migrated = 0;
+    updateEEPROM(EEPROM_BOOL_programHasRunBefore, &migrated, 1);
+    return true;
 }
 /**
 =================================================== \n
@@ -234,14 +487,6 @@ void criticalError(errorCase error) {
 // noMode is only used in nextMode
 enum systemMode {standard, economic, maintenance, config, noMode};
 
-// -- Toggle GPS --
-// Determines if the GPS is read during the next execution of economic mode
-bool readGPSnextExec;
-
-// -- Measure timing --
-// Time when economic / standard / maintenance systemMode will be executed next
-unsigned long nextMeasureTimer = 0;
-
 // -- Switch systemMode --
 // Current systemMode variable
 // DO NOT CHANGE THIS OUTSIDE THE 'switchMode()' FUNCTION OR STUFF WILL BREAK
@@ -255,7 +500,35 @@ systemMode lastModeBeforeMaintenance;
 
 // Contains the time in ms, when the system mode is changed,
 // used after interrupts and in config mode
-unsigned long switchModeTimer = 0;
+uint32_t switchModeTimer = 0;
+
+// Defined in the BME 280 section
+void applyBMEprofile(systemMode mode);
+
+// Defined in the GPS section
+void wakeGPS();
+
+// Defined in the SD Card section
+void closeCurrentFile();
+void closeLogDirectory();
+
+// Defined in the Tasks section
+void startModeTasks();
+void writeHeldRecord();
+
+// -- LED color of each mode --
+colorValue modeColor(systemMode mode) {
+    switch (mode) {
+        case economic:
+            return Blue;
+        case maintenance:
+            return Orange;
+        case config:
+            return Yellow;
+        default:
+            return Green;
+    }
+}
 
 // systemMode switching function
 void switchMode(systemMode newMode){
@@ -263,41 +536,47 @@ void switchMode(systemMode newMode){
     nextMode = noMode;
     switchModeTimer = 0;
 
-    // Sets the time threshold for the next measure back to 0
-    nextMeasureTimer = 0;
+    // The tasks of the new mode run right away, so makes sure the GPS is ready for its first reading
+    wakeGPS();
 
-    // Makes sure the GPS is read during the next reading
-    readGPSnextExec = true;
+    // The last reading held back by DEADBAND ends the trace of the previous mode
+    writeHeldRecord();
 
     switch (newMode) {
         // Standard
         case standard :
-            setLEDcolor(getColor(Green));
             lastModeBeforeMaintenance = standard;
+            applyBMEprofile(standard);
             break;
 
         // Economic
         case economic :
-            setLEDcolor(getColor(Blue));
             lastModeBeforeMaintenance = economic;
+            applyBMEprofile(economic);
             break;
 
         // Maintenance
         case maintenance:
-            setLEDcolor(getColor(Orange));
+            // Flush the LOG buffer and close the current file, so the SD card can be removed
+            closeCurrentFile();
+            closeLogDirectory();
+            applyBMEprofile(standard);
             break;
 
         // Config
         case config:
-            switchModeTimer = millis() + configTimeout;
-            setLEDcolor(getColor(Yellow));
+            switchModeTimer = deadlineIn(configTimeout);
             break;
 
         case noMode:
             //noMode is not allowed as a system mode, returning to previous mode
             return;
     }
+    setLEDcolor(getColor(modeColor(newMode)));
     currentMode = newMode;
+
+    // Each mode has its own task periods, see 'taskPolicies'
+    startModeTasks();
 }
 
 // -- Interrupts --
@@ -330,7 +609,7 @@ void greenButtonInterrupt() {
         if (currentMode == economic) {
             nextMode = standard;
         }
-        switchModeTimer = millis() + buttonPressTime;
+        switchModeTimer = deadlineIn(buttonPressTime);
     }
     else {
         nextMode = noMode;
@@ -368,7 +647,7 @@ void redButtonInterrupt() {
         if (currentMode == maintenance) {
             nextMode = lastModeBeforeMaintenance;
         }
-        switchModeTimer = millis() + buttonPressTime;
+        switchModeTimer = deadlineIn(buttonPressTime);
     }
     else {
         nextMode = noMode;
@@ -378,11 +657,133 @@ void redButtonInterrupt() {
 }
 
 // -- Make a string for assembling the data to log --
-// 73 characters are reserved for this String in 'Setup()'
-String dataString;
+// Values are formatted straight into this buffer, so sampling never allocates heap memory.
+// It holds the longest NMEA sentence (82 characters) followed by 'valueSeparator'
+#define maxNMEAlength 82
+char dataString[maxNMEAlength + 4];
+
+// -- Texts in flash --
+// The AVR copies every string literal to its 2 KB of SRAM at boot, unless it is kept in flash with F(), PSTR()
+// or PROGMEM. Texts are therefore always printed with F() and formatted with 'appendText()' from flash
+#define flashText(text) ((const __FlashStringHelper*)(text))
 
 // Separator placed between RTC, GPS and sensor data in 'dataString'
-String valueSeparator = " ; ";
+const char valueSeparator[] PROGMEM = " ; ";
+
+// -- Formatting functions --
+// Each one writes at 'str' and returns the end of what it wrote, so calls can be chained.
+// The result is only null terminated by 'appendText()'
+
+// Copies a null terminated text from flash, e.g. PSTR("N/A")
+char* appendText(char* str, const char* text) {
+    char c;
+    while ((c = pgm_read_byte(text++)) != '\0') {
+        *str++ = c;
+    }
+    *str = '\0';
+    return str;
+}
+
+// Writes an unsigned number, using SdFat's 'fmtBase10()' which formats from the end of a buffer
+char* appendNumber(char* str, uint32_t value) {
+    char digits[10];
+    char* start = fmtBase10(digits + sizeof(digits), value);
+
+    while (start < digits + sizeof(digits)) {
+        *str++ = *start++;
+    }
+    return str;
+}
+
+// Writes a fixed point number, e.g. 2345 with 2 decimals is written as 23.45
+char* appendFixedPoint(char* str, int32_t value, unsigned char decimals) {
+    if (value < 0) {
+        *str++ = '-';
+        value = -value;
+    }
+
+    uint32_t divisor = 1;
+    for (unsigned char i = 0; i < decimals; i++) {
+        divisor *= 10;
+    }
+
+    str = appendNumber(str, value / divisor);
+    if (decimals > 0) {
+        *str++ = '.';
+
+        // Leading zeros of the decimal part
+        uint32_t fraction = value % divisor;
+        for (divisor /= 10; divisor > 1 && fraction < divisor; divisor /= 10) {
+            *str++ = '0';
+        }
+        str = appendNumber(str, fraction);
+    }
+    return str;
+}
+
+// Writes a two digit, zero padded number
+char* appendTwoDigits(char* str, unsigned char value) {
+    *str++ = '0' + value / 10;
+    *str++ = '0' + value % 10;
+    return str;
+}
+
+// -- GPS fix --
+// Parsed from the latest GGA sentence, also part of the binary LOG record
+struct GGAfix {
+    uint32_t time;              // UTC time of the fix (in s since midnight)
+    int32_t latitude;           // Latitude (in 1/1000000 °, north is positive)
+    int32_t longitude;          // Longitude (in 1/1000000 °, east is positive)
+    int32_t altitude;           // Altitude above mean sea level (in 1/100 m)
+    uint16_t HDOP;              // Horizontal dilution of precision (in 1/100)
+    uint8_t quality;            // 0 : no fix, 1 : GPS, 2 : DGPS, ...
+    uint8_t satellites;         // Number of satellites in use
+} __attribute__((packed));
+
+// -- Binary LOG record --
+// Written as a whole once per reading if LOG_FORMAT is binaryFormat,
+// the layout must be kept in sync with 'tools/decodeLog.py'
+struct logRecord {
+    uint32_t timestamp;         // Seconds since 01/01/2000 00:00:00 (RTC time)
+    int16_t temperature;        // Temperature (in 1/100 °C)
+    uint16_t humidity;          // Relative humidity (in 1/100 %)
+    uint32_t pressure;          // Pressure (in Pa)
+    uint16_t light;             // Raw luminosity sensor reading (0 - 1023)
+    uint8_t lightClass;         // 0 : LOW, 1 : AVG, 2 : HIGH
+    uint8_t valid;              // Fields containing a valid reading, see 'recordFlag'
+    GGAfix position;            // Latest GPS fix, the position is only valid with 'GPS_valid'
+    uint16_t positionAge;       // Time since 'position' was received (in s)
+} __attribute__((packed)) currentRecord;
+
+// -- Enum containing the validity bits of 'logRecord.valid' --
+// 'Rate_changed' marks the first record after the LOG interval was adapted to the pressure tendency,
+// 'Statistics_record' a record followed by a 'statisticsRecord' in binary LOG files
+enum recordFlag {RTC_valid = 1, GPS_valid = 2, Light_valid = 4, Temperature_valid = 8, Humidity_valid = 16, Pressure_valid = 32, Rate_changed = 64, Statistics_record = 128};
+
+// -- Summary of a channel over a LOG interval --
+// In the unit of the channel in 'logRecord', whose value is then the mean
+struct channelSummary {
+    int32_t minimum;
+    int32_t maximum;
+    uint16_t deviation;         // Sample standard deviation, 0 with less than 2 samples
+    uint16_t count;             // Number of samples, the channel is not valid without any
+} __attribute__((packed));
+
+// -- Binary statistics record --
+// Written right after the 'logRecord' it belongs to if STATISTICS is set,
+// the layout must be kept in sync with 'tools/decodeLog.py'
+struct statisticsRecord {
+    channelSummary temperature;
+    channelSummary humidity;
+    channelSummary pressure;
+    channelSummary light;
+} __attribute__((packed)) currentStatistics;
+
+// Projected size of a text LOG line (in bytes), without the raw GGA sentence of GPS_RAW
+#define textRecordSize 100
+
+// Projected size added to a text LOG line by the summaries of STATISTICS (in bytes)
+#define textStatisticsSize 160
 
 /**
 =================================================== \n
@@ -393,89 +794,374 @@ String valueSeparator = " ; ";
 SdFat32 SD;
 SdFile currentFile;
 
-// 16 characters are reserved for this String in 'Setup()'
-String fileName;
+// -- LOG buffering --
+// Records are written through SdFat's own 512 byte sector cache, there is no room for a sector buffer of our own
+// in the Uno's 2 KB of SRAM. Syncing a normal file and extending its FAT chain go through that same cache, so the
+// partially filled sector is read back from the card after each flush and each new cluster.
+// Only preallocated files are written in whole sectors, see below
+#define sectorSize 512
+
+// -- Preallocated LOG files --
+// If PREALLOCATE is set, a new LOG file gets a contiguous extent of FILE_MAX_SIZE bytes and full
+// sectors are written straight to the card, so there is no FAT traffic while logging.
+// The sector being filled is kept in SdFat's cache, which is not used by anything else until the file is closed
+bool rawLogging = false;
+
+// Contiguous sector range reserved for the current file
+uint32_t rawFirstSector;
+uint32_t rawLastSector;
+
+// Bytes written to the current preallocated file, including those of the sector in the cache
+uint32_t rawDataSize;
+
+// SdFat's cache, holds the sector being filled while 'rawLogging'
+uint8_t* rawSector;
+
+// Sector of the preallocated extent that holds the next byte
+uint32_t rawCurrentSector() {
+    return rawFirstSector + rawDataSize / sectorSize;
+}
+
+// -- Writes the sector just completed in the cache to the card --
+// A record is shorter than a sector, so at most one sector completes per write and a multiple sector write
+// would only be left open between records, and across sleeps. Each sector is a single write instead
+void commitRawSector() {
+    uint32_t sector = rawCurrentSector() - 1;
+    if (sector > rawLastSector || !SD.card()->writeSector(sector, rawSector)) {
+        criticalError(SDfull_error);
+    }
+}
+
+// -- Writes the partially filled sector in the cache to the card --
+// The rest of the sector is zeroed, which marks the end of the data should power be lost.
+// The next bytes complete the sector in the cache, and it is written again as a whole
+void writePartialRawSector() {
+    size_t used = rawDataSize % sectorSize;
+    if (used == 0) {
+        return;
+    }
+
+    memset(rawSector + used, 0, sectorSize - used);
+    if (rawCurrentSector() > rawLastSector || !SD.card()->writeSector(rawCurrentSector(), rawSector)) {
+        criticalError(SDfull_error);
+    }
+}
+
+// Name of the current LOG file, 'YYMMDD_RRR.LOG'
+char fileName[15];
+
+// -- Current LOG file --
+// Files are created directly under their final name '/YYYY/MM/DD/YYMMDD_R.LOG', the revision restarts at 1 every day.
+// This is kept in EEPROM so rotating never has to search the SD card for the next free revision
+struct logFile {
+    unsigned char year;         // RTC year (0 - 99)
+    unsigned char month;
+    unsigned char day;
+    unsigned char revision;     // 0 if no LOG file has been created yet
+} currentLogFile;
+
+// Wite currentLogFile to EEPROM, only the changed bytes are written
+void writeLogFileToEEPROM() {
+    updateEEPROM(EEPROM_logFile, &currentLogFile, sizeof(logFile));
+}
 
-// Current LOG file revision number
-unsigned char revision = 1;
+// Fetch currentLogFile from EEPROM
+void getLogFileFromEEPROM() {
+    EEPROM.get(EEPROM_logFile, currentLogFile);
+}
 
 bool fileOpen = false;
 
-// Selects a file to write to, renames the current LOG file if it is full and creates a new one
-void selectFile () {
+// Size of the current file, a preallocated file's size is FILE_MAX_SIZE until it gets closed
+unsigned long currentFileSize() {
+    return rawLogging ? rawDataSize : currentFile.fileSize();
+}
+
+// -- Writes data to the current file --
+// Full sectors of a preallocated file are written to the card as soon as they are complete
+void bufferedWrite(const void* data, size_t count) {
+    if (!rawLogging) {
+        if (currentFile.write(data, count) != count) {
+            criticalError(SDfull_error);
+        }
+        return;
+    }
+
+    const unsigned char* bytes = (const unsigned char*)data;
+    while (count > 0) {
+        size_t used = rawDataSize % sectorSize;
+        size_t n = min(count, sectorSize - used);
+        memcpy(rawSector + used, bytes, n);
+        rawDataSize += n;
+        bytes += n;
+        count -= n;
+
+        if (rawDataSize % sectorSize == 0) {
+            commitRawSector();
+        }
+    }
+}
+
+// Writes everything left in the cache and closes the current file
+// Called before rotating the file and before switching to maintenance mode
+void closeCurrentFile() {
     if (!fileOpen) {
-        if (!currentFile.open("000000_0.LOG", O_RDWR | O_CREAT | O_AT_END)) {
+        return;
+    }
+
+    // Give the unused part of the preallocated extent back, SdFat may use its cache again from here on
+    if (rawLogging) {
+        writePartialRawSector();
+        rawLogging = false;
+        if (!currentFile.truncate(rawDataSize)) {
             criticalError(SDread_error);
         }
-        fileOpen = true;
     }
 
-    // If projected filesize < FILE_MAX_SIZE bytes
-    if ((currentFile.fileSize() + 125 < currentSystemConfiguration.FILE_MAX_SIZE)) {
+    currentFile.close();
+    fileOpen = false;
+}
+
+// -- Writes the partial sector waiting in the cache to the card --
+// Called by the flush task, so a power cut loses at most one flush period of data.
+// Syncing a normal file updates its directory entry through the cache, so the sector is read back on the next
+// write. A preallocated file keeps the sector in the cache and writes it again as a whole
+void flushLogBuffer() {
+    if (!fileOpen) {
         return;
     }
 
-        // If projected filesize > FILE_MAX_SIZE bytes
-    else {
-        currentFile.close();
-        while(true) {
-            fileName = clock.year;
-            fileName += clock.month;
-            fileName += clock.dayOfMonth;
-            fileName += "_";
-            fileName += revision;
-            fileName += ".LOG";
-
-            // Check if file with that revision number already exists
-            if (SD.exists(fileName.c_str())){
-                revision++;
+    if (rawLogging) {
+        writePartialRawSector();
+    }
+    else if (!currentFile.sync()) {
+        criticalError(SDread_error);
+    }
+}
+
+// -- Clears the extent reserved for a new preallocated file --
+// The clusters still hold whatever an older file left there. Erased sectors read as all 0x00 or all 0xFF,
+// so 'findEndOfData()' can tell where the data stops should power be lost before the file is closed.
+// Cards that cannot erase the range get it written with zeros, through the cache that is free at this point
+bool clearRawExtent() {
+    if (SD.card()->erase(rawFirstSector, rawLastSector)) {
+        return true;
+    }
+
+    memset(rawSector, 0, sectorSize);
+    if (!SD.card()->writeStart(rawFirstSector)) {
+        return false;
+    }
+    for (uint32_t sector = rawFirstSector; sector <= rawLastSector; sector++) {
+        if (!SD.card()->writeData(rawSector)) {
+            SD.card()->writeStop();
+            return false;
+        }
+    }
+    return SD.card()->writeStop();
+}
+
+// True if 'count' bytes are all 0x00 or all 0xFF, as left by an erase or by 'clearRawExtent()'
+bool erasedData(const char* data, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (data[i] != data[0] || (data[i] != 0 && data[i] != (char)0xFF)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// -- Size of the data in the current file --
+// A preallocated file that was not closed, e.g. after a power loss, keeps its preallocated size.
+// Its data stops at the first binary record that is all 0x00 or all 0xFF, or at the first 0x00 or 0xFF byte
+// of a text file. Other files are returned whole
+uint32_t findEndOfData() {
+    uint32_t size = currentFile.fileSize();
+    uint32_t end = 0;
+    currentFile.rewind();
+
+    if (binaryLogging()) {
+        while (end + sizeof(logRecord) <= size) {
+            currentFile.read(dataString, sizeof(logRecord));
+            if (erasedData(dataString, sizeof(logRecord))) {
+                break;
             }
-                // If it doesn't exist, rename the current revision 0 file to it
-            else {
-                if(!SD.rename("000000_0.LOG", fileName)) {
-                    criticalError(SDread_error);
-                }
 
-                if (!currentFile.open("000000_0.LOG", O_RDWR | O_CREAT | O_AT_END)) {
-                    criticalError(SDread_error);
-                }
-                return;
+            end += sizeof(logRecord);
+            if (((logRecord*)dataString)->valid & Statistics_record) {
+                end += sizeof(statisticsRecord);
+                currentFile.seekSet(end);
             }
         }
+        return min(end, size);
     }
-}
 
-void writeTocurrentFile(const String& dataToWrite, bool newLine) {
-    if(!(currentMode == standard || currentMode == economic)) {
-        if (newLine) {
-            Serial.println(dataToWrite);
+    while (end < size) {
+        int count = currentFile.read(dataString, sizeof(dataString));
+        if (count <= 0) {
+            break;
         }
-        else {
-            Serial.print(dataToWrite);
+        for (int i = 0; i < count; i++, end++) {
+            if (dataString[i] == 0 || dataString[i] == (char)0xFF) {
+                return end;
+            }
         }
+    }
+    return size;
+}
+
+// Writes the name of the current LOG file to 'fileName', the extension depends on LOG_FORMAT
+void makeFileName() {
+    char* str = appendTwoDigits(fileName, currentLogFile.year);
+    str = appendTwoDigits(str, currentLogFile.month);
+    str = appendTwoDigits(str, currentLogFile.day);
+    *str++ = '_';
+    str = appendNumber(str, currentLogFile.revision);
+    appendText(str, binaryLogging() ? PSTR(".BIN") : PSTR(".LOG"));
+}
+
+// Defined in the RTC section
+void readClock();
+
+// Moves currentLogFile on to the next revision of today
+void nextLogFile() {
+    readClock();
+
+    if (clock.year != currentLogFile.year || clock.month != currentLogFile.month || clock.dayOfMonth != currentLogFile.day) {
+        currentLogFile.year = clock.year;
+        currentLogFile.month = clock.month;
+        currentLogFile.day = clock.dayOfMonth;
+        currentLogFile.revision = 0;
+    }
+    currentLogFile.revision++;
+
+    writeLogFileToEEPROM();
+}
+
+// -- LOG directory --
+// Each day gets its own '/YYYY/MM/DD' directory, so no directory ever holds more than one day of files.
+// The directory of the current file is kept open, so opening the next revision does not walk the path again
+SdFile logDirectory;
+
+// Date of the open 'logDirectory'
+unsigned char logDirectoryYear, logDirectoryMonth, logDirectoryDay;
 
+void closeLogDirectory() {
+    if (logDirectory.isOpen()) {
+        logDirectory.close();
+    }
+}
+
+// Opens the directory of the current LOG file, creating it if necessary
+void openLogDirectory() {
+    if (logDirectory.isOpen() && logDirectoryYear == currentLogFile.year
+        && logDirectoryMonth == currentLogFile.month && logDirectoryDay == currentLogFile.day) {
         return;
     }
+    closeLogDirectory();
+
+    // '/YYYY/MM/DD'
+    char path[12];
+    char* str = appendText(path, PSTR("/20"));
+    str = appendTwoDigits(str, currentLogFile.year);
+    *str++ = '/';
+    str = appendTwoDigits(str, currentLogFile.month);
+    *str++ = '/';
+    str = appendTwoDigits(str, currentLogFile.day);
+    *str = '\0';
+
+    // 'mkdir()' creates the missing parent directories and leaves the new directory open
+    if (!logDirectory.open(path, O_RDONLY) && !logDirectory.mkdir(SD.vwd(), path)) {
+        criticalError(SDread_error);
+    }
 
-    if (newLine) {
-        currentFile.println(dataToWrite);
-        Serial.println(dataToWrite);
+    logDirectoryYear = currentLogFile.year;
+    logDirectoryMonth = currentLogFile.month;
+    logDirectoryDay = currentLogFile.day;
+}
 
-        // Print file name
-        Serial.print("R : ");
-        Serial.println(revision);
+// Opens the current file and preallocates it if it is new and PREALLOCATE is set
+void openCurrentFile() {
+    // No LOG file has been created since the EEPROM was initialised
+    if (currentLogFile.revision == 0 || currentLogFile.revision == 0xFF) {
+        nextLogFile();
+    }
+    makeFileName();
+    openLogDirectory();
 
-        // Print file size
-        Serial.print("S : ");
-        Serial.print(currentFile.fileSize());
-        Serial.println(" B");
-        Serial.println("");
+    if (!currentFile.open(&logDirectory, fileName, O_RDWR | O_CREAT | O_AT_END)) {
+        criticalError(SDread_error);
+    }
+
+    // An existing file is appended to normally, without the unused end it has kept if it was preallocated
+    if (currentFile.fileSize() > 0) {
+        uint32_t end = findEndOfData();
+        if (end < currentFile.fileSize() ? !currentFile.truncate(end) : !currentFile.seekEnd()) {
+            criticalError(SDread_error);
+        }
+    }
+
+    // Only new files can be preallocated
+    else if (currentSystemConfiguration.PREALLOCATE == 1) {
+        if (currentFile.preAllocate(currentSystemConfiguration.FILE_MAX_SIZE)) {
+            rawLogging = currentFile.contiguousRange(&rawFirstSector, &rawLastSector);
+            rawDataSize = 0;
 
+            if (rawLogging) {
+                // Nothing else may use the cache until the file is closed, 'cacheClear()' writes out what it held
+                rawSector = SD.cacheClear();
+                rawLogging = rawSector != nullptr && clearRawExtent();
+            }
+            if (!rawLogging) {
+                currentFile.truncate(0);
+            }
+        }
+    }
+
+    fileOpen = true;
+}
+
+// Defined in the Pressure tendency section
+extern bool rateChanged;
+
+// Projected size of the line logged for a change of the LOG interval (in bytes)
+#define rateEventSize 64
+
+// Selects a file to write to, creates the next revision if the current LOG file is full
+void selectFile () {
+    if (!fileOpen) {
+        openCurrentFile();
+    }
+
+    unsigned int recordSize = binaryLogging() ? sizeof(logRecord) : textRecordSize;
+    if (statisticsLogging()) {
+        recordSize += binaryLogging() ? sizeof(statisticsRecord) : textStatisticsSize;
+    }
+
+    // The record held back by DEADBAND may be written before the current one
+    if (deadbandLogging()) {
+        recordSize *= 2;
+    }
+    if (!binaryLogging() && currentSystemConfiguration.GPS_RAW) {
+        recordSize += maxNMEAlength + sizeof(valueSeparator);
+    }
+    if (!binaryLogging() && rateChanged) {
+        recordSize += rateEventSize;
+    }
+
+    // If projected filesize < FILE_MAX_SIZE bytes
+    if ((currentFileSize() + recordSize < currentSystemConfiguration.FILE_MAX_SIZE)) {
+        return;
     }
 
+        // If projected filesize > FILE_MAX_SIZE bytes
     else {
-        currentFile.print(dataToWrite);
-        Serial.print(dataToWrite);
+        closeCurrentFile();
+
+        // Should the next revision already exist (e.g. after the EEPROM was reset), it is appended to
+        // and rotated again once full, so no directory search is ever needed
+        nextLogFile();
+        openCurrentFile();
     }
 }
 
@@ -486,9 +1172,29 @@ void writeTocurrentFile(const String& dataToWrite, bool newLine) {
 ===================================================
 */
 
-ForcedClimate BMESensor = ForcedClimate();
+#define BME280address 0x76
+ForcedClimate BMESensor = ForcedClimate(Wire, BME280address);
+
+// -- Fixed point BME280 readings --
+// Temperature in 1/100 °C, humidity in 1/100 % and pressure in Pa.
+// All three are read in a single I2C transfer, once the conversion started by 'startBMEmeasurement()' is done.
+// FORCED_CLIMATE_FIXED_POINT is set in platformio.ini, so the library compensates the readings with
+// integer math only, without it the float results are converted
+void readBMEvalues(int32_t& temperature, uint32_t& humidity, uint32_t& pressure) {
+#ifdef FORCED_CLIMATE_INTEGER
+    BMESensor.collect(temperature, pressure, humidity);
+#else
+    float floatTemperature, floatPressure, floatHumidity;
+    BMESensor.collect(floatTemperature, floatPressure, floatHumidity);
+
+    temperature = lround(floatTemperature * 100);
+    humidity = lround(floatHumidity * 100);
+    pressure = lround(floatPressure * 100);
+#endif
+}
 
-bool inRange(const float& value, const int& min, const int& max) {
+// 'min' and 'max' have to be given in the same unit as 'value'
+bool inRange(const int32_t& value, const int32_t& min, const int32_t& max) {
     if (value < min) {
         return false;
     }
@@ -499,44 +1205,71 @@ bool inRange(const float& value, const int& min, const int& max) {
 }
 
 
-void readBMEdata(String& output) {
-    //-- BME280 Readings --
-    BMESensor.takeForcedMeasurement();
+// -- BME280 sampling profiles --
+// Converts an oversampling multiplier (1, 2, 4, 8, 16) to its register value (1 - 5)
+unsigned char oversamplingRegister(unsigned char oversampling) {
+    unsigned char value = 0;
+    while (oversampling > 0) {
+        oversampling >>= 1;
+        value++;
+    }
+    return value;
+}
 
-    //Temperature
-    float temperature = BMESensor.getTemperatureCelcius();
+// Converts an IIR filter coefficient (0, 2, 4, 8, 16) to its register value (0 - 4)
+unsigned char filterRegister(unsigned char filter) {
+    return filter == 0 ? 0 : oversamplingRegister(filter) - 1;
+}
 
-    if (currentSystemConfiguration.ACTIVATE_THERMOMETER) {
-        if (inRange(temperature, currentSystemConfiguration.THERMOMETER_MIN_TEMPERATURE, currentSystemConfiguration.THERMOMETER_MAX_TEMPERATURE)) {
-            output = String(temperature);
+// Economic mode has its own profile, standard and maintenance mode share one
+// The settings are written to the BME280 at the start of the next measurement
+void applyBMEprofile(systemMode mode) {
+    if (mode == economic) {
+        BMESensor.setSampling(oversamplingRegister(currentSystemConfiguration.ECONOMIC_OVERSAMPLING),
+                              filterRegister(currentSystemConfiguration.ECONOMIC_FILTER));
+    }
+    else {
+        BMESensor.setSampling(oversamplingRegister(currentSystemConfiguration.STANDARD_OVERSAMPLING),
+                              filterRegister(currentSystemConfiguration.STANDARD_FILTER));
+    }
+}
 
-            output += valueSeparator;
+// -- Starts a BME280 conversion --
+// It runs in the background, the BME task collects it once 'BMESensor.measurementReady()'
+void startBMEmeasurement() {
+    BMESensor.startMeasurement();
+}
+
+// -- Stores the finished conversion in 'currentRecord' --
+// Readings of a deactivated sensor or outside of their valid range are left out of the record
+void readBMEdata() {
+    int32_t temperature;
+    uint32_t humidity, pressure;
+    readBMEvalues(temperature, humidity, pressure);
 
-            writeTocurrentFile(output, false);
+    currentRecord.valid &= ~(Temperature_valid | Humidity_valid | Pressure_valid);
+
+    //Temperature (in 1/100 °C)
+    if (currentSystemConfiguration.ACTIVATE_THERMOMETER) {
+        if (inRange(temperature, currentSystemConfiguration.THERMOMETER_MIN_TEMPERATURE * 100L, currentSystemConfiguration.THERMOMETER_MAX_TEMPERATURE * 100L)) {
+            currentRecord.temperature = temperature;
+            currentRecord.valid |= Temperature_valid;
         }
     }
 
     //Humidity
     if (currentSystemConfiguration.ACTIVATE_HYGROMETRY_SENSOR) {
-        if (inRange(temperature, currentSystemConfiguration.MIN_TEMPERATURE_FOR_HYGROMETRY, currentSystemConfiguration.MAX_TEMPERATURE_FOR_HYGROMETRY)) {
-            output = String(BMESensor.getRelativeHumidity());
-
-            output += valueSeparator;
-
-            writeTocurrentFile(output, false);
+        if (inRange(temperature, currentSystemConfiguration.MIN_TEMPERATURE_FOR_HYGROMETRY * 100L, currentSystemConfiguration.MAX_TEMPERATURE_FOR_HYGROMETRY * 100L)) {
+            currentRecord.humidity = humidity;
+            currentRecord.valid |= Humidity_valid;
         }
     }
 
-    //Pressure
-    float pressure = BMESensor.getPressure();
-
+    //Pressure (in Pa)
     if (currentSystemConfiguration.ACTIVATE_PRESSURE_SENSOR) {
-        if (inRange(pressure, currentSystemConfiguration.MIN_VALID_PRESSURE, currentSystemConfiguration.MAX_VALID_PRESSURE)) {
-            output = String(pressure);
-
-            output += valueSeparator;
-
-            writeTocurrentFile(output, true);
+        if (inRange(pressure, currentSystemConfiguration.MIN_VALID_PRESSURE * 100L, currentSystemConfiguration.MAX_VALID_PRESSURE * 100L)) {
+            currentRecord.pressure = pressure;
+            currentRecord.valid |= Pressure_valid;
         }
     }
 }
@@ -544,551 +1277,2222 @@ void readBMEdata(String& output) {
 
 /**
 =================================================== \n
-====================== RTC Stuff ===================== \n
+=================== Pressure tendency ================== \n
 ===================================================
 */
 
+// The pressure is recorded every 10 minutes for the last 3 hours. Its tendency is the least squares slope over the
+// last hour and over the last 3 hours, both kept up to date incrementally as samples enter and leave the history.
+// A falling pressure shortens the LOG interval and a steady one lengthens it, see 'updateSamplingRate()'
+#define tendencySlotsPerHour 6
+#define tendencySlotTime (3600000UL / tendencySlotsPerHour)    // Time between two samples (in ms)
+#define tendencySlots (3 * tendencySlotsPerHour + 1)            // 3 hours of samples, both ends included
+#define shortTendencySlots (tendencySlotsPerHour + 1)           // 1 hour of samples
+
+// Samples (in 1/10 hPa), written in a circle
+uint16_t pressureHistory[tendencySlots];
+unsigned char historyHead = 0;      // Next slot to write
+unsigned char historyCount = 0;     // Samples in the history, up to 'tendencySlots'
+
+// -- Sliding least squares window over the newest samples --
+// 'weightedSum' weights each sample by its index in the window, 0 being the oldest one
+struct slopeWindow {
+    int32_t sum;
+    int32_t weightedSum;
+};
 
-// -- Adds the time to a String --
-void readTime(String& output)
-{
-    clock.getTime();
-    output = clock.hour;
-    output += ":";
-    output += clock.minute;
-    output += ":";
-    output += clock.second;
-    output += "-";
-    output += clock.month;
-    output += "/";
-    output += clock.dayOfMonth;
-    output += "/";
-    output += (clock.year + 2000);
-    output += valueSeparator;
-
-    writeTocurrentFile(output, false);
-}
+slopeWindow shortWindow, longWindow;
 
+// Tendencies over the last hour and the last 3 hours (in 1/10 hPa per hour)
+int16_t shortTendency = 0;
+int16_t longTendency = 0;
 
-/**
-=================================================== \n
-=================== Light sensor Stuff ================== \n
-===================================================
-*/
+bool shortTendencyKnown() {
+    return historyCount >= shortTendencySlots;
+}
 
+bool longTendencyKnown() {
+    return historyCount >= tendencySlots;
+}
 
-void readLightSensorData(String& output) {
-    //Return if luminosity sensor is disabled
-    if (!currentSystemConfiguration.ACTIVATE_LUMINOSITY_SENSOR) {
+// Adds 'sample' to a window of 'size' samples, the oldest one drops out once the window is full.
+// Must be called before 'sample' is written to the history
+void slideWindow(slopeWindow& window, unsigned char size, uint16_t sample) {
+    if (historyCount < size) {
+        window.weightedSum += (int32_t)historyCount * sample;
+        window.sum += sample;
         return;
     }
 
-    unsigned int data = analogRead(lightSensorPIN);
-    if (data < currentSystemConfiguration.LUMINOSITY_LOW_THRESHOLD) {
-        output = "LOW";
-    }
-    else if ((data < currentSystemConfiguration.LUMINOSITY_HIGH_THRESHOLD)) {
-        output = "AVG";
-    }
-    else {
-        output = "HIGH";
-    }
-    output += valueSeparator;
+    // The remaining samples move down one index, the new one takes the last
+    uint16_t oldest = pressureHistory[(historyHead + tendencySlots - size) % tendencySlots];
+    window.weightedSum += (int32_t)(size - 1) * sample - (window.sum - oldest);
+    window.sum += (int32_t)sample - oldest;
+}
 
-    writeTocurrentFile(output, false);
+// Least squares slope of a full window, converted from per slot to per hour
+int16_t windowSlope(const slopeWindow& window, unsigned char size) {
+    int32_t numerator = 12 * window.weightedSum - 6L * (size - 1) * window.sum;
+    return numerator * tendencySlotsPerHour / ((int32_t)size * (size * size - 1));
 }
 
+// Starts over, a gap would distort the slopes
+void clearPressureHistory() {
+    historyHead = 0;
+    historyCount = 0;
+    shortWindow = slopeWindow();
+    longWindow = slopeWindow();
+}
 
-/**
+// Adds a pressure (in Pa) to the history and updates the tendencies
+void addPressureSample(uint32_t pressure) {
+    uint16_t sample = (pressure + 5) / 10;
+
+    slideWindow(shortWindow, shortTendencySlots, sample);
+    slideWindow(longWindow, tendencySlots, sample);
+
+    pressureHistory[historyHead] = sample;
+    historyHead = (historyHead + 1) % tendencySlots;
+    if (historyCount < tendencySlots) {
+        historyCount++;
+    }
+
+    if (shortTendencyKnown()) {
+        shortTendency = windowSlope(shortWindow, shortTendencySlots);
+    }
+    if (longTendencyKnown()) {
+        longTendency = windowSlope(longWindow, tendencySlots);
+    }
+}
+
+// -- Writes a tendency, e.g. '-1.2 hPa/h', or N/A --
+char* appendTendency(char* str, bool known, int16_t tendency) {
+    if (!known) {
+        return appendText(str, PSTR("N/A"));
+    }
+    return appendText(appendFixedPoint(str, tendency, 1), PSTR(" hPa/h"));
+}
+
+// -- Adaptive sampling --
+// fastRate : the pressure fell by TENDENCY_FALL or more per hour over the last hour or 3 hours, LOG_INTERVALL / 4
+// slowRate : the pressure changed by less than TENDENCY_FALL / 4 per hour over both, LOG_INTERVALL * 2
+// Fast sampling only ends once the fall is below TENDENCY_FALL / 2, so the rate does not flap around the threshold
+enum samplingRate {normalRate, fastRate, slowRate};
+
+samplingRate currentRate = normalRate;
+
+// Set when the rate changed, until the change is logged
+bool rateChanged = false;
+
+// Time between two readings at the current rate (in ms)
+uint32_t logInterval() {
+    uint32_t interval = minutesToMs(currentSystemConfiguration.LOG_INTERVALL);
+
+    if (currentRate == fastRate) {
+        return interval / 4;
+    }
+    if (currentRate == slowRate) {
+        return interval * 2;
+    }
+    return interval;
+}
+
+// True if 'tendency' is strictly between -limit and limit
+bool steadyTendency(int16_t tendency, int16_t limit) {
+    return tendency < limit && tendency > -limit;
+}
+
+// Returns true if the rate changed
+bool updateSamplingRate() {
+    int16_t threshold = currentSystemConfiguration.TENDENCY_FALL;
+    samplingRate rate = normalRate;
+
+    if (threshold > 0 && shortTendencyKnown()) {
+        int16_t fall = -shortTendency;
+        if (longTendencyKnown() && -longTendency > fall) {
+            fall = -longTendency;
+        }
+
+        int16_t fastThreshold = currentRate == fastRate ? (threshold + 1) / 2 : threshold;
+        int16_t steadyLimit = (threshold + 3) / 4;
+
+        if (fall >= fastThreshold) {
+            rate = fastRate;
+        }
+        else if (longTendencyKnown() && steadyTendency(shortTendency, steadyLimit) && steadyTendency(longTendency, steadyLimit)) {
+            rate = slowRate;
+        }
+    }
+
+    if (rate == currentRate) {
+        return false;
+    }
+
+    currentRate = rate;
+    rateChanged = true;
+    return true;
+}
+
+/**
+=================================================== \n
+====================== Statistics ===================== \n
+===================================================
+*/
+
+// With STATISTICS, the light and BME tasks sample every SAMPLE_PERIOD instead of once per LOG interval.
+// Every sample goes into the running statistics of its channel, and the LOG task replaces the latest
+// sample with the mean over the interval, adds the minimum, maximum, deviation and count and starts over.
+// The SD card gets one record per LOG interval either way
+
+// In the order of 'statisticsRecord'
+enum statisticsChannel {temperature_channel, humidity_channel, pressure_channel, light_channel, channelCount};
+
+// Validity bit of each channel in 'logRecord.valid'
+const unsigned char channelFlagTable[channelCount] PROGMEM = {Temperature_valid, Humidity_valid, Pressure_valid, Light_valid};
+
+unsigned char channelFlag(unsigned char channel) {
+    return pgm_read_byte(&channelFlagTable[channel]);
+}
+
+runningStatistics channelStatistics[channelCount];
+
+// Time between two samples (in ms), stretched if needed so a LOG interval holds at most 'statisticsMaxCount' of them
+uint32_t samplePeriod() {
+    uint32_t shortest = logInterval() / (statisticsMaxCount - 1) + 1;
+    return max(currentSystemConfiguration.SAMPLE_PERIOD * 1000UL, shortest);
+}
+
+// Defined in the Light sensor section
+unsigned char lightClass(unsigned int data);
+
+// Starts a new LOG interval
+void clearChannelStatistics() {
+    for (unsigned char channel = 0; channel < channelCount; channel++) {
+        clearStatistics(channelStatistics[channel]);
+    }
+}
+
+// Value of a channel in 'currentRecord'
+int32_t recordValue(unsigned char channel) {
+    switch (channel) {
+        case temperature_channel:
+            return currentRecord.temperature;
+        case humidity_channel:
+            return currentRecord.humidity;
+        case pressure_channel:
+            return currentRecord.pressure;
+        default:
+            return currentRecord.light;
+    }
+}
+
+// Sets a channel in 'currentRecord', the luminosity with its class
+void setRecordValue(unsigned char channel, int32_t value) {
+    switch (channel) {
+        case temperature_channel:
+            currentRecord.temperature = value;
+            break;
+        case humidity_channel:
+            currentRecord.humidity = value;
+            break;
+        case pressure_channel:
+            currentRecord.pressure = value;
+            break;
+        default:
+            currentRecord.light = value;
+            currentRecord.lightClass = lightClass(value);
+            break;
+    }
+}
+
+// -- Adds the valid readings of the channels in 'flags' to their statistics --
+// Called by the sensor tasks once they stored a sample in 'currentRecord'
+void sampleChannels(unsigned char flags) {
+    if (!statisticsLogging()) {
+        return;
+    }
+
+    for (unsigned char channel = 0; channel < channelCount; channel++) {
+        if (flags & currentRecord.valid & channelFlag(channel)) {
+            addSample(channelStatistics[channel], recordValue(channel));
+        }
+    }
+}
+
+// -- Replaces the latest samples in 'currentRecord' with the means over the LOG interval --
+// Fills 'currentStatistics' and starts a new interval. A channel without any sample is not valid
+void summarizeChannels() {
+    channelSummary* summaries = &currentStatistics.temperature;
+
+    for (unsigned char channel = 0; channel < channelCount; channel++) {
+        const runningStatistics& statistics = channelStatistics[channel];
+        channelSummary& summary = summaries[channel];
+
+        summary.count = statistics.count;
+        if (statistics.count == 0) {
+            summary.minimum = summary.maximum = 0;
+            summary.deviation = 0;
+            currentRecord.valid &= ~channelFlag(channel);
+            continue;
+        }
+
+        summary.minimum = statistics.minimum;
+        summary.maximum = statistics.maximum;
+        summary.deviation = min(statisticsDeviation(statistics), (uint32_t)UINT16_MAX);
+        currentRecord.valid |= channelFlag(channel);
+        setRecordValue(channel, statisticsMean(statistics));
+    }
+
+    clearChannelStatistics();
+}
+
+// Appends the summary of a channel, e.g. ' (21.40..21.70 sd 0.08 n 12)'
+char* appendSummary(char* str, const channelSummary& summary, unsigned char decimals) {
+    str = appendText(str, PSTR(" ("));
+    str = appendText(appendFixedPoint(str, summary.minimum, decimals), PSTR(".."));
+    str = appendText(appendFixedPoint(str, summary.maximum, decimals), PSTR(" sd "));
+    str = appendText(appendFixedPoint(str, summary.deviation, decimals), PSTR(" n "));
+    return appendText(appendNumber(str, summary.count), PSTR(")"));
+}
+
+
+/**
+=================================================== \n
+====================== RTC Stuff ===================== \n
+===================================================
+*/
+
+
+// -- Seconds elapsed since 01/01/2000 00:00:00 --
+// 'year' is the RTC year (0 - 99)
+uint32_t secondsSince2000(unsigned char year, unsigned char month, unsigned char day,
+                          unsigned char hour, unsigned char minute, unsigned char second) {
+    // Days before the first of each month in a non leap year
+    static const unsigned short int daysBeforeMonth[] PROGMEM = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+
+    // 2000 is a leap year, so every year divisible by 4 up to 2099 is one
+    uint32_t days = year * 365UL + (year + 3) / 4 + pgm_read_word(&daysBeforeMonth[(month - 1) % 12]) + day - 1;
+    if (month > 2 && year % 4 == 0) {
+        days++;
+    }
+
+    return ((days * 24 + hour) * 60 + minute) * 60 + second;
+}
+
+// -- Fills the date and time fields of 'clock' from seconds elapsed since 01/01/2000 00:00:00 --
+void splitSecondsSince2000(uint32_t seconds) {
+    static const unsigned char daysInMonth[] PROGMEM = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+    clock.second = seconds % 60;
+    seconds /= 60;
+    clock.minute = seconds % 60;
+    seconds /= 60;
+    clock.hour = seconds % 24;
+
+    unsigned int days = seconds / 24;
+
+    // 01/01/2000 was a saturday, 'dayOfWeek' starts with monday = 1
+    clock.dayOfWeek = (days + 5) % 7 + 1;
+
+    // Blocks of 4 years starting with a leap year
+    unsigned char year = days / 1461 * 4;
+    days %= 1461;
+    if (days >= 366) {
+        days -= 366;
+        year += 1 + days / 365;
+        days %= 365;
+    }
+    clock.year = year;
+
+    unsigned char month = 0;
+    unsigned int monthLength = pgm_read_byte(&daysInMonth[0]);
+    while (days >= monthLength) {
+        days -= monthLength;
+        month++;
+        monthLength = pgm_read_byte(&daysInMonth[month]);
+        if (month == 1 && year % 4 == 0) {
+            monthLength++;
+        }
+    }
+    clock.month = month + 1;
+    clock.dayOfMonth = days + 1;
+}
+
+// -- Software clock --
+// The DS1307 is only read by the RTC task every 'RTCsyncInterval', in between the time is counted with millis().
+// The Arduino's resonator can be off by up to 0.5 %, which keeps the error within 3 s
+#define RTCsyncInterval 600000UL
+
+// Time (in s since 01/01/2000) at 'clockAnchorMillis'
+uint32_t clockAnchor = 0;
+unsigned long clockAnchorMillis = 0;
+bool clockAnchored = false;
+
+// Number of times the RTC was corrected with the GPS time
+unsigned int clockCorrections = 0;
+
+// Current time (in s since 01/01/2000)
+uint32_t currentTime() {
+    return clockAnchor + (millis() - clockAnchorMillis) / 1000;
+}
+
+// Re-anchors the software clock from the DS1307, this also fills the fields of 'clock'
+// Without RTC the clock keeps counting from 01/01/2000 or from the last GPS time
+void syncClockFromRTC() {
+    if (!RTCpresent) {
+        clockAnchor = currentTime();
+        clockAnchorMillis = millis();
+        clockAnchored = true;
+        splitSecondsSince2000(clockAnchor);
+        return;
+    }
+
+    clock.getTime();
+    clockAnchor = secondsSince2000(clock.year, clock.month, clock.dayOfMonth, clock.hour, clock.minute, clock.second);
+    clockAnchorMillis = millis();
+    clockAnchored = true;
+}
+
+// -- Fills the date and time fields of 'clock' with the current time --
+// Replaces 'clock.getTime()', the DS1307 is only read when the software clock is due for a re-anchor
+void readClock() {
+    if (!clockAnchored || millis() - clockAnchorMillis >= RTCsyncInterval) {
+        syncClockFromRTC();
+        return;
+    }
+
+    splitSecondsSince2000(currentTime());
+}
+
+// -- Disciplines the clock with the UTC time of a GPS fix --
+// GGA only contains the time of day, the date is taken from the clock, which has to be within 12 h of UTC.
+// The DS1307 is only written if it is 2 s or more off
+void syncClockFromGPS(uint32_t timeOfDay) {
+    if (!clockAnchored) {
+        syncClockFromRTC();
+    }
+
+    uint32_t now = currentTime();
+    uint32_t GPStime = now - now % 86400 + timeOfDay;
+
+    // Around midnight, the fix can belong to the previous or next day
+    if (GPStime > now + 43200) {
+        GPStime -= 86400;
+    }
+    else if (GPStime + 43200 < now) {
+        GPStime += 86400;
+    }
+
+    clockAnchor = GPStime;
+    clockAnchorMillis = millis();
+
+    if (RTCpresent && (GPStime >= now + 2 || GPStime + 2 <= now)) {
+        splitSecondsSince2000(GPStime);
+        clock.setTime();
+        clockCorrections++;
+    }
+}
+
+
+/**
+=================================================== \n
+=================== Light sensor Stuff ================== \n
+===================================================
+*/
+
+
+// -- Class of a luminosity reading --
+// 0 : LOW, 1 : AVG, 2 : HIGH
+unsigned char lightClass(unsigned int data) {
+    if (data < currentSystemConfiguration.LUMINOSITY_LOW_THRESHOLD) {
+        return 0;
+    }
+    else if ((data < currentSystemConfiguration.LUMINOSITY_HIGH_THRESHOLD)) {
+        return 1;
+    }
+    else {
+        return 2;
+    }
+}
+
+// -- Stores the luminosity and its class in 'currentRecord' --
+void readLightSensorData() {
+    //Leave the luminosity out of the record if the sensor is disabled
+    if (!currentSystemConfiguration.ACTIVATE_LUMINOSITY_SENSOR) {
+        currentRecord.valid &= ~Light_valid;
+        return;
+    }
+
+    unsigned int data = analogRead(lightSensorPIN);
+    currentRecord.light = data;
+    currentRecord.lightClass = lightClass(data);
+    currentRecord.valid |= Light_valid;
+}
+
+
+/**
+=================================================== \n
+====================== GPS Stuff ===================== \n
+===================================================
+*/
+
+// Open SoftSerial for GPS
+SoftwareSerial SoftSerial(RX, TX);
+
+bool timeout_GPS = false;
+
+// -- Incremental NMEA parser --
+// The SoftwareSerial interrupt fills its 64 byte buffer, 'pollGPS()' empties it one character at a time,
+// so a reading never has to wait for a sentence
+enum NMEAstate {NMEA_idle, NMEA_body, NMEA_checksumHigh, NMEA_checksumLow};
+NMEAstate NMEAparserState = NMEA_idle;
+
+// -- Sentence being received, from '$' up to (not including) '*' --
+// Only GGA sentences are used, so only they are kept : the start of every sentence goes to 'NMEAheader',
+// and only a GGA sentence goes on into 'NMEAbuffer'. The last GGA sentence stays there for GPS_RAW
+// until the next one starts
+#define NMEAheaderLength 7      // "$GPGGA,"
+char NMEAheader[NMEAheaderLength];
+char NMEAbuffer[maxNMEAlength + 1];
+unsigned char NMEAlength = 0;
+
+// True while a GGA sentence is received into 'NMEAbuffer'
+bool NMEAkeep = false;
+
+// True while 'NMEAbuffer' holds a complete GGA sentence with a valid checksum
+bool rawGGAvalid = false;
+
+// XOR of all characters between '$' and '*', compared to the checksum sent by the GPS
+unsigned char NMEAchecksum = 0;
+unsigned char NMEAreceivedChecksum = 0;
+
+// Number of sentences dropped because of a wrong checksum or because they were too long
+unsigned int NMEAerrors = 0;
+
+// Latest GGA sentence with a valid checksum and the time it was received at,
+// the raw sentence is only logged if GPS_RAW is set
+GGAfix lastFix;
+unsigned long lastGGAtime = 0;
+
+// Set once a GGA sentence was received since the GPS was last woken up
+bool GGAreceived = false;
+
+// Time the clock was last synchronized with the GPS
+unsigned long lastGPSclockSync = 0;
+bool GPSclockSynced = false;
+
+// -- Last known fix --
+// Kept across standby and logged with its age when no newer fix is available
+GGAfix cachedFix;
+unsigned long cachedFixTime = 0;
+bool fixCached = false;
+
+// -- Returns the value of a hexadecimal digit, 0xFF if it is none --
+unsigned char hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return 0xFF;
+}
+
+// Defined below
+bool parseGGA(const char* sentence, GGAfix& fix);
+
+// -- Called once a sentence and its checksum are complete --
+void NMEAsentenceReceived() {
+    if (NMEAchecksum != NMEAreceivedChecksum) {
+        NMEAerrors++;
+        return;
+    }
+
+    if (NMEAkeep) {
+        NMEAbuffer[NMEAlength] = '\0';
+        rawGGAvalid = true;
+
+        lastGGAtime = millis();
+        GGAreceived = true;
+        GPSpresent = true;
+
+        // A malformed sentence still shows that the GPS responds, but the last fix, the cached one
+        // and the clock are left as they were
+        if (parseGGA(NMEAbuffer, lastFix) && lastFix.quality != 0) {
+            cachedFix = lastFix;
+            cachedFixTime = lastGGAtime;
+            fixCached = true;
+
+            // The RTC is corrected at the same rate the software clock is re-anchored from it
+            if (currentSystemConfiguration.CLOCK_SYNC && (!GPSclockSynced || lastGGAtime - lastGPSclockSync >= RTCsyncInterval)) {
+                syncClockFromGPS(lastFix.time);
+                lastGPSclockSync = lastGGAtime;
+                GPSclockSynced = true;
+            }
+        }
+    }
+}
+
+// -- Feeds one character to the NMEA parser --
+void parseNMEAcharacter(char c) {
+    // A new sentence always restarts the parser, even in the middle of a broken one
+    if (c == '$') {
+        NMEAparserState = NMEA_body;
+        NMEAheader[0] = c;
+        NMEAlength = 1;
+        NMEAchecksum = 0;
+        NMEAkeep = false;
+        return;
+    }
+
+    unsigned char digit;
+
+    switch (NMEAparserState) {
+        case NMEA_idle:
+            break;
+
+        case NMEA_body:
+            if (c == '*') {
+                NMEAparserState = NMEA_checksumHigh;
+            }
+            else if (c == '\r' || c == '\n' || NMEAlength >= maxNMEAlength) {
+                // Sentences without checksum or longer than allowed are dropped
+                NMEAerrors++;
+                NMEAparserState = NMEA_idle;
+            }
+            else {
+                if (NMEAkeep) {
+                    NMEAbuffer[NMEAlength] = c;
+                }
+                else if (NMEAlength < NMEAheaderLength) {
+                    NMEAheader[NMEAlength] = c;
+
+                    // Any talker ID ($GPGGA, $GNGGA, ...), the last GGA sentence gets overwritten from here on
+                    if (NMEAlength == NMEAheaderLength - 1 && strncmp_P(NMEAheader + 3, PSTR("GGA,"), 4) == 0) {
+                        memcpy(NMEAbuffer, NMEAheader, NMEAheaderLength);
+                        NMEAkeep = true;
+                        rawGGAvalid = false;
+                    }
+                }
+                NMEAlength++;
+                NMEAchecksum ^= c;
+            }
+            break;
+
+        case NMEA_checksumHigh:
+        case NMEA_checksumLow:
+            digit = hexValue(c);
+            if (digit == 0xFF) {
+                NMEAerrors++;
+                NMEAparserState = NMEA_idle;
+            }
+            else if (NMEAparserState == NMEA_checksumHigh) {
+                NMEAreceivedChecksum = digit << 4;
+                NMEAparserState = NMEA_checksumLow;
+            }
+            else {
+                NMEAreceivedChecksum |= digit;
+                NMEAparserState = NMEA_idle;
+                NMEAsentenceReceived();
+            }
+            break;
+    }
+}
+
+// -- Sends a PMTK command, '$', the checksum and the line ending are added --
+void sendPMTKcommand(const char* command) {
+    static const char hexDigits[] PROGMEM = "0123456789ABCDEF";
+
+    unsigned char checksum = 0;
+    for (const char* c = command; *c; c++) {
+        checksum ^= *c;
+    }
+
+    SoftSerial.write('$');
+    SoftSerial.write(command);
+    SoftSerial.write('*');
+    SoftSerial.write(pgm_read_byte(&hexDigits[checksum >> 4]));
+    SoftSerial.write(pgm_read_byte(&hexDigits[checksum & 0x0F]));
+    SoftSerial.print(F("\r\n"));
+}
+
+// -- Applies GPS_SENTENCES and GPS_RATE to the GPS --
+// Every byte received costs a SoftwareSerial interrupt, so only the sentences that are used are enabled
+void configureGPS() {
+    // PMTK_SET_NMEA_OUTPUT, 19 fields, a field is 1 to send that sentence with every fix
+    char command[48];
+    char* str = appendText(command, PSTR("PMTK314"));
+    for (unsigned char i = 0; i < 19; i++) {
+        *str++ = ',';
+        *str++ = (i < 6 && bitRead(currentSystemConfiguration.GPS_SENTENCES | GGA_sentence, i)) ? '1' : '0';
+    }
+    *str = '\0';
+    sendPMTKcommand(command);
+
+    // PMTK_SET_NMEA_UPDATERATE
+    str = appendNumber(appendText(command, PSTR("PMTK220,")), currentSystemConfiguration.GPS_RATE);
+    *str = '\0';
+    sendPMTKcommand(command);
+}
+
+// -- GPS standby --
+// In standby the GPS keeps its ephemeris, so it gets a hot start fix within a few seconds of waking up
+bool GPSasleep = false;
+
+// Any byte wakes the GPS up, PMTK000 is the harmless test command
+void wakeGPS() {
+    if (!GPSasleep) {
+        return;
+    }
+
+    char command[8];
+    appendText(command, PSTR("PMTK000"));
+    sendPMTKcommand(command);
+    GPSasleep = false;
+    GGAreceived = false;
+}
+
+// Puts the GPS in standby if the current mode allows it and its next use is further away than GPS_WARMUP
+void standbyGPS(uint32_t nextUse) {
+    bool allowed = (currentMode == economic && currentSystemConfiguration.GPS_STANDBY != noStandby)
+                || (currentMode == standard && currentSystemConfiguration.GPS_STANDBY == alwaysStandby);
+
+    if (GPSasleep || !allowed || timeLeft(nextUse) <= currentSystemConfiguration.GPS_WARMUP * 1000UL) {
+        return;
+    }
+
+    char command[10];
+    appendText(command, PSTR("PMTK161,0"));
+    sendPMTKcommand(command);
+    GPSasleep = true;
+}
+
+// -- Empties the SoftwareSerial buffer into the NMEA parser --
+// Has to be called at least every 60 ms (64 characters at 9600 baud) to not lose characters
+void pollGPS() {
+    while (SoftSerial.available()) {
+        parseNMEAcharacter(SoftSerial.read());
+    }
+}
+
+// -- Returns the start of field 'index' of an NMEA sentence --
+// Field 0 is the sentence type, returns nullptr if the sentence has less fields
+const char* NMEAfield(const char* sentence, unsigned char index) {
+    while (index > 0) {
+        sentence = strchr(sentence, ',');
+        if (sentence == nullptr) {
+            return nullptr;
+        }
+        sentence++;
+        index--;
+    }
+    return sentence;
+}
+
+// -- Converts an NMEA coordinate ((d)ddmm.mmmm) to 1/1000000 ° --
+int32_t parseNMEAcoordinate(const char* field) {
+    // Degrees and whole minutes
+    uint32_t whole = 0;
+    while (isdigit(*field)) {
+        whole = whole * 10 + (*field - '0');
+        field++;
+    }
+
+    // Decimal minutes, up to 5 digits are used
+    uint32_t fraction = 0;
+    uint32_t scale = 100000;
+    if (*field == '.') {
+        field++;
+        while (isdigit(*field) && scale > 1) {
+            scale /= 10;
+            fraction += (*field - '0') * scale;
+            field++;
+        }
+    }
+
+    // Minutes in 1/100000 min, then converted to 1/1000000 °
+    uint32_t minutes = (whole % 100) * 100000 + fraction;
+    return (whole / 100) * 1000000L + (minutes * 10 + 3) / 6;
+}
+
+// -- Converts an NMEA decimal number to fixed point with 'decimals' decimals --
+// Further decimals are cut off, an empty field is 0
+int32_t parseNMEAdecimal(const char* field, unsigned char decimals) {
+    bool negative = *field == '-';
+    if (negative) {
+        field++;
+    }
+
+    int32_t value = 0;
+    while (isdigit(*field)) {
+        value = value * 10 + (*field - '0');
+        field++;
+    }
+
+    if (*field == '.') {
+        field++;
+    }
+    for (; decimals > 0; decimals--) {
+        value *= 10;
+        if (isdigit(*field)) {
+            value += *field - '0';
+            field++;
+        }
+    }
+
+    return negative ? -value : value;
+}
+
+// -- Converts an NMEA time (hhmmss.ss) to s since midnight --
+// Returns false if the field is empty or not a valid time of day
+bool parseNMEAtime(const char* field, uint32_t& time) {
+    for (unsigned char i = 0; i < 6; i++) {
+        if (!isdigit(field[i])) {
+            return false;
+        }
+    }
+
+    uint32_t hhmmss = parseNMEAdecimal(field, 0);
+    unsigned char hours = hhmmss / 10000;
+    unsigned char minutes = hhmmss / 100 % 100;
+    unsigned char seconds = hhmmss % 100;
+    if (hours > 23 || minutes > 59 || seconds > 59) {
+        return false;
+    }
+
+    time = hours * 3600UL + minutes * 60 + seconds;
+    return true;
+}
+
+// -- Parses a GGA sentence into 'fix' --
+// $xxGGA,hhmmss.ss,llll.ll,a,yyyyy.yy,a,q,ss,h.h,a.a,M,...
+// Returns false, leaving 'fix' unchanged, if a field is missing or malformed.
+// Without a fix (quality 0) the GPS may leave the time and the position empty
+bool parseGGA(const char* sentence, GGAfix& fix) {
+    const char* field[10];
+    for (unsigned char i = 1; i < 10; i++) {
+        field[i] = NMEAfield(sentence, i);
+        if (field[i] == nullptr) {
+            return false;
+        }
+    }
+
+    if (!isdigit(*field[6])) {
+        return false;
+    }
+
+    GGAfix parsed;
+    parsed.quality = parseNMEAdecimal(field[6], 0);
+    parsed.satellites = parseNMEAdecimal(field[7], 0);
+    parsed.HDOP = parseNMEAdecimal(field[8], 2);
+    parsed.altitude = parseNMEAdecimal(field[9], 2);
+    parsed.latitude = 0;
+    parsed.longitude = 0;
+
+    uint32_t time = 0;
+    bool timeValid = parseNMEAtime(field[1], time);
+    parsed.time = time;
+
+    if (parsed.quality != 0) {
+        if (!timeValid || !isdigit(*field[2]) || !isdigit(*field[4])
+            || (*field[3] != 'N' && *field[3] != 'S') || (*field[5] != 'E' && *field[5] != 'W')) {
+            return false;
+        }
+
+        parsed.latitude = parseNMEAcoordinate(field[2]);
+        parsed.longitude = parseNMEAcoordinate(field[4]);
+        if (parsed.latitude > 90000000L || parsed.longitude > 180000000L) {
+            return false;
+        }
+
+        if (*field[3] == 'S') {
+            parsed.latitude = -parsed.latitude;
+        }
+        if (*field[5] == 'W') {
+            parsed.longitude = -parsed.longitude;
+        }
+    }
+
+    fix = parsed;
+    return true;
+}
+
+// -- Writes the position, e.g. "48.858370 2.294481 35.20m 8sat H0.90" --
+// The age is only added to fixes of 2 s or older, as 'tools/decodeLog.py' does
+char* appendFix(char* str, const GGAfix& fix, uint16_t age) {
+    str = appendFixedPoint(str, fix.latitude, 6);
+    *str++ = ' ';
+    str = appendFixedPoint(str, fix.longitude, 6);
+    *str++ = ' ';
+    str = appendFixedPoint(str, fix.altitude, 2);
+    str = appendText(str, PSTR("m "));
+    str = appendNumber(str, fix.satellites);
+    str = appendText(str, PSTR("sat H"));
+    str = appendFixedPoint(str, fix.HDOP, 2);
+
+    if (age >= 2) {
+        str = appendText(str, PSTR(" ("));
+        str = appendNumber(str, age);
+        str = appendText(str, PSTR("s)"));
+    }
+    return str;
+}
+
+// -- GPS check --
+// True if the GPS answered at its last check, the records until it is stale then show 'NO FIX' instead of N/A
+// and the raw GGA sentence, see 'logTask()'
+bool GPSresponding = false;
+
+// Called by the GPS task, two checks in a row without a GGA sentence are a GPS error
+void checkGPS() {
+    // Take in what arrived since the last 'loop()'
+    pollGPS();
+
+    // The GPS sends a GGA sentence every GPS_RATE ms, none for 'TIMEOUT' ms means it stopped responding
+    GPSresponding = GGAreceived && millis() - lastGGAtime < currentSystemConfiguration.TIMEOUT;
+
+    // Without a GPS at boot, no position is no error
+    if (GPSpresent) {
+        if (!GPSresponding && timeout_GPS) {
+            criticalError(GPS_error);
+        }
+        timeout_GPS = !GPSresponding;
+    }
+}
+
+// -- Stores the last known fix and its age in 'currentRecord' --
+void readGPS() {
+    currentRecord.valid &= ~GPS_valid;
+
+    if (fixCached) {
+        unsigned long age = (millis() - cachedFixTime) / 1000;
+        currentRecord.positionAge = age > 0xFFFF ? 0xFFFF : age;
+        currentRecord.position = cachedFix;
+        currentRecord.valid |= GPS_valid;
+    }
+    else if (GPSresponding) {
+        // Satellites are still logged while there is no fix
+        currentRecord.position = lastFix;
+    }
+}
+
+/**
+=================================================== \n
+======================== Tasks ======================== \n
+===================================================
+*/
+
+// Every sensor, the LOG file, the serial output and the LED are handled by their own task, with its own period.
+// The tasks run one after the other from 'loop()' and each one returns quickly : a task that has to wait for
+// something (e.g. a BME280 conversion) returns the time after which it wants to be called again in the same period.
+// How often each task runs in each mode is data, see 'taskPolicies'
+
+// -- Tasks, in the order they run in when due at the same time --
+// The sensors come before the LOG task, so a reading logs the samples taken in the same period
+enum taskID {GPS_task, RTC_task, light_task, BME_task, tendency_task, log_task, report_task, flush_task, LED_task, taskCount};
+
+// -- Task return value --
+// Anything else is the time (in ms) after which the task is called again in the same period
+#define taskDone 0
+
+typedef uint16_t (*taskFunction)();
+
+// -- Task periods --
+// Either in seconds or in multiples of LOG_INTERVALL, adapted to the pressure tendency by 'logInterval()'.
+// Sampling tasks run in multiples of SAMPLE_PERIOD instead if STATISTICS is set.
+// 'onDemand' tasks only run when started by 'startTask()'
+#define logIntervalPeriod 0x8000
+#define samplingPeriod 0x4000
+#define periodSeconds(n) (n)
+#define periodLogIntervals(n) (logIntervalPeriod | (n))
+#define periodSamples(n) (samplingPeriod | logIntervalPeriod | (n))
+#define onDemand 0
+
+// -- Task policies --
+// Period of every task in each mode, in the order of 'systemMode' and 'taskID'.
+// Economic mode logs every second LOG_INTERVALL, samples half as often and only uses the GPS for every second reading.
+// The partial sector of the LOG buffer is written to the card every 30 minutes
+#define RTCperiod periodSeconds(RTCsyncInterval / 1000)
+#define tendencyPeriod periodSeconds(tendencySlotTime / 1000)
+#define flushPeriod periodSeconds(1800)
+
+const uint16_t taskPolicies[4][taskCount] PROGMEM = {
+    // GPS                  RTC         Light                   BME                     Tendency        LOG                     Report      Flush           LED
+    {periodLogIntervals(1), RTCperiod,  periodSamples(1),       periodSamples(1),       tendencyPeriod, periodLogIntervals(1),  onDemand,   flushPeriod,    onDemand},  // standard
+    {periodLogIntervals(4), RTCperiod,  periodSamples(2),       periodSamples(2),       tendencyPeriod, periodLogIntervals(2),  onDemand,   flushPeriod,    onDemand},  // economic
+    {periodLogIntervals(1), RTCperiod,  periodSamples(1),       periodSamples(1),       tendencyPeriod, periodLogIntervals(1),  onDemand,   onDemand,       onDemand},  // maintenance
+    {onDemand,              RTCperiod,  onDemand,               onDemand,               tendencyPeriod, onDemand,               onDemand,   onDemand,       onDemand},  // config
+};
+
+// -- Task state --
+struct taskState {
+    uint32_t deadline;      // Next time the task is called
+    uint32_t nextPeriod;    // Start of the task's next period
+} tasks[taskCount];
+
+uint16_t activeTasks = 0;   // Bit per task, set while the task has a deadline
+uint16_t waitingTasks = 0;  // Bit per task, set while the task waits within its current period
+
+// Entry of 'taskPolicies' for the current mode
+uint16_t taskPolicy(unsigned char task) {
+    return pgm_read_word(&taskPolicies[currentMode][task]);
+}
+
+// Period of a task in the current mode (in ms), 0 if it only runs on demand
+uint32_t taskPeriod(unsigned char task) {
+    uint16_t period = taskPolicy(task);
+    uint16_t count = period & ~(logIntervalPeriod | samplingPeriod);
+
+    if ((period & samplingPeriod) && statisticsLogging()) {
+        return samplePeriod() * count;
+    }
+    if (period & logIntervalPeriod) {
+        return logInterval() * count;
+    }
+    return period * 1000UL;
+}
+
+// Starts a new period of the task in 'delay' ms
+void startTask(taskID task, uint32_t delay) {
+    tasks[task].deadline = deadlineIn(delay);
+    activeTasks |= 1 << task;
+    waitingTasks &= ~(1 << task);
+}
+
+bool taskActive(taskID task) {
+    return activeTasks & (1 << task);
+}
+
+// -- Brings the tasks counted in LOG_INTERVALL forward if their period got shorter --
+// Called when the sampling rate changes, a longer period only applies from the next one on
+void rescheduleLogIntervalTasks() {
+    uint32_t now = schedulerTime();
+
+    for (unsigned char task = 0; task < taskCount; task++) {
+        uint16_t mask = 1 << task;
+        if (!(activeTasks & mask) || (waitingTasks & mask) || !(taskPolicy(task) & logIntervalPeriod)) {
+            continue;
+        }
+
+        tasks[task].deadline = earliestDeadline(now, tasks[task].deadline, now + taskPeriod(task));
+    }
+}
+
+// -- GPS task --
+// The GPS is woken up GPS_WARMUP seconds before the task, and put back in standby after it if allowed
+uint32_t GPSwakeTime() {
+    return tasks[GPS_task].deadline - currentSystemConfiguration.GPS_WARMUP * 1000UL;
+}
+
+void wakeGPSbeforeReading() {
+    if (GPSasleep && taskActive(GPS_task) && deadlineReached(GPSwakeTime())) {
+        wakeGPS();
+    }
+}
+
+uint16_t GPStask() {
+    checkGPS();
+
+    // Only in standard and economic mode, if allowed by GPS_STANDBY
+    standbyGPS(tasks[GPS_task].nextPeriod);
+    return taskDone;
+}
+
+// -- RTC task --
+// Re-anchors the software clock
+uint16_t RTCtask() {
+    syncClockFromRTC();
+    return taskDone;
+}
+
+// -- Light sensor task --
+uint16_t lightTask() {
+    readLightSensorData();
+    sampleChannels(Light_valid);
+    return taskDone;
+}
+
+// -- BME280 task --
+// Starts a conversion, then checks every 'BMEpollTime' ms if it is done
+#define BMEpollTime 10
+
+bool BMEconverting = false;
+uint32_t BMEtimeout;
+
+// Time of the last reading, false until the first one
+bool BMEsampled = false;
+uint32_t BMEsampleTime;
+
+uint16_t BMEtask() {
+    // Degraded mode, the BME280 did not answer at boot and its readings stay N/A
+    if (!BMEpresent) {
+        return taskDone;
+    }
+
+    if (!BMEconverting) {
+        startBMEmeasurement();
+        BMEconverting = true;
+        BMEtimeout = deadlineIn(currentSystemConfiguration.TIMEOUT);
+        return BMEpollTime;
+    }
+
+    if (!BMESensor.measurementReady()) {
+        if (deadlineReached(BMEtimeout)) {
+            criticalError(Sensor_error);
+        }
+        return BMEpollTime;
+    }
+
+    BMEconverting = false;
+    readBMEdata();
+    sampleChannels(Temperature_valid | Humidity_valid | Pressure_valid);
+    BMEsampled = true;
+    BMEsampleTime = schedulerTime();
+    return taskDone;
+}
+
+// -- Pressure tendency task --
+// Adds the pressure to the history every 'tendencySlotTime'. If the BME task has not read the pressure in the
+// last half slot, it is run now, so the history is not made of stale readings
+uint16_t tendencyTask() {
+    if (!BMEpresent) {
+        return taskDone;
+    }
+
+    if (BMEconverting) {
+        // A mode switch may have stopped the BME task during its conversion
+        if (!taskActive(BME_task)) {
+            startTask(BME_task, 0);
+        }
+        return BMEpollTime;
+    }
+
+    if (!BMEsampled || schedulerTime() - BMEsampleTime > tendencySlotTime / 2) {
+        startTask(BME_task, 0);
+        BMEsampled = false;
+        return BMEpollTime;
+    }
+
+    if (currentRecord.valid & Pressure_valid) {
+        addPressureSample(currentRecord.pressure);
+    }
+    else {
+        clearPressureHistory();
+    }
+
+    // A faster rate takes effect right away
+    if (updateSamplingRate()) {
+        rescheduleLogIntervalTasks();
+    }
+    return taskDone;
+}
+
+// -- Text form of a record --
+// True if the GPS answered for 'currentRecord', see 'GPSresponding'
+bool recordGPSresponding = false;
+
+// Lets 'writeRecordText()' write to the LOG file
+struct logBufferPrint : public Print {
+    size_t write(uint8_t c) {
+        bufferedWrite(&c, 1);
+        return 1;
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) {
+        bufferedWrite(buffer, size);
+        return size;
+    }
+} logPrint;
+
+// Writes a BME280 reading in 1/100 of its unit, N/A for an active sensor if the BME280 is missing.
+// Nothing is written for a deactivated sensor or a reading outside of its valid range.
+// The reading is followed by its summary in a record of STATISTICS
+void printBMEvalue(Print& output, bool valid, bool active, int32_t value, const channelSummary& summary) {
+    if (valid) {
+        char* str = appendFixedPoint(dataString, value, 2);
+        if (currentRecord.valid & Statistics_record) {
+            str = appendSummary(str, summary, 2);
+        }
+        appendText(str, valueSeparator);
+    }
+    else if (active && !BMEpresent) {
+        appendText(appendText(dataString, PSTR("N/A")), valueSeparator);
+    }
+    else {
+        return;
+    }
+    output.print(dataString);
+}
+
+// Writes 'currentRecord' as one line to a text LOG file or to the serial monitor.
+// GPS and RTC are N/A without a reading, the BME280 channels only if the BME280 is missing
+void writeRecordText(Print& output) {
+    // -- GPS --
+    char* str;
+    if (currentRecord.valid & GPS_valid) {
+        str = appendFix(dataString, currentRecord.position, currentRecord.positionAge);
+    }
+    else if (recordGPSresponding) {
+        str = appendText(dataString, PSTR("NO FIX"));
+    }
+    else {
+        str = appendText(dataString, PSTR("N/A"));
+    }
+    appendText(str, valueSeparator);
+    output.print(dataString);
+
+    // Raw sentence, for debugging
+    if (recordGPSresponding && currentSystemConfiguration.GPS_RAW && rawGGAvalid) {
+        output.print(NMEAbuffer);
+        output.print(flashText(valueSeparator));
+    }
+
+    // -- RTC --
+    if (currentRecord.valid & RTC_valid) {
+        // Also fills 'clock', which is refilled by 'readClock()' before being used again
+        splitSecondsSince2000(currentRecord.timestamp);
+        str = appendTwoDigits(dataString, clock.hour);
+        *str++ = ':';
+        str = appendTwoDigits(str, clock.minute);
+        *str++ = ':';
+        str = appendTwoDigits(str, clock.second);
+        *str++ = '-';
+        str = appendTwoDigits(str, clock.month);
+        *str++ = '/';
+        str = appendTwoDigits(str, clock.dayOfMonth);
+        *str++ = '/';
+        str = appendNumber(str, clock.year + 2000);
+    }
+    else {
+        str = appendText(dataString, PSTR("N/A"));
+    }
+    appendText(str, valueSeparator);
+    output.print(dataString);
+
+    // -- Light sensor --
+    if (currentRecord.valid & Light_valid) {
+        static const char lightClasses[][5] PROGMEM = {"LOW", "AVG", "HIGH"};
+        str = appendText(dataString, lightClasses[currentRecord.lightClass]);
+        if (currentRecord.valid & Statistics_record) {
+            str = appendSummary(str, currentStatistics.light, 0);
+        }
+        appendText(str, valueSeparator);
+        output.print(dataString);
+    }
+
+    // -- BME280 --
+    printBMEvalue(output, currentRecord.valid & Temperature_valid, currentSystemConfiguration.ACTIVATE_THERMOMETER, currentRecord.temperature, currentStatistics.temperature);
+    printBMEvalue(output, currentRecord.valid & Humidity_valid, currentSystemConfiguration.ACTIVATE_HYGROMETRY_SENSOR, currentRecord.humidity, currentStatistics.humidity);
+    printBMEvalue(output, currentRecord.valid & Pressure_valid, currentSystemConfiguration.ACTIVATE_PRESSURE_SENSOR, currentRecord.pressure, currentStatistics.pressure);
+
+    output.println();
+}
+
+// Writes a change of the sampling rate as one line, e.g. 'RATE FAST 30 s ; -1.2 hPa/h ; -0.8 hPa/h ; '
+// with the tendencies over the last hour and the last 3 hours
+void writeRateEvent(Print& output) {
+    static const char rateNames[][8] PROGMEM = {"NORMAL ", "FAST ", "SLOW "};
+
+    char* str = appendText(appendText(dataString, PSTR("RATE ")), rateNames[currentRate]);
+    str = appendText(appendNumber(str, logInterval() / 1000), PSTR(" s"));
+    str = appendText(str, valueSeparator);
+    str = appendText(appendTendency(str, shortTendencyKnown(), shortTendency), valueSeparator);
+    appendText(appendTendency(str, longTendencyKnown(), longTendency), valueSeparator);
+    output.println(dataString);
+}
+
+// Number of readings since boot, and of those written to the LOG file
+unsigned long readingCount = 0;
+unsigned long recordsWritten = 0;
+
+// -- Writes 'currentRecord' to the LOG file --
+// Followed by its statistics if it has some
+void writeRecord() {
+    if (binaryLogging()) {
+        bufferedWrite(&currentRecord, sizeof(logRecord));
+        if (currentRecord.valid & Statistics_record) {
+            bufferedWrite(&currentStatistics, sizeof(statisticsRecord));
+        }
+    }
+    else {
+        writeRecordText(logPrint);
+    }
+    recordsWritten++;
+}
+
+// -- Deadband logging --
+// With DEADBAND, a reading is only written once it differs from the last written one :
+// - temperature, humidity or luminosity moved by more than their DEADBAND_ threshold
+// - a channel became valid or invalid, or the LOG interval changed
+// - nothing was written for MAX_SILENCE minutes
+// Until then the reading is held back, so the values in between stay within the thresholds of the last record.
+// The pressure is compressed by the swinging door algorithm instead, see 'swingingDoor.h' : every record starts
+// a door with DEADBAND_PRESSURE as deviation. Once a reading closes the door, the reading held back before it is
+// written. A written record gets the pressure closest to its reading on the door, so the straight line between
+// two records passes within DEADBAND_PRESSURE (plus 1 Pa of rounding) of every reading in between.
+// A reading more than 163 hPa or 18 h away from the last record closes the door, it is then written as read
+
+// Last written record, its readings are the reference of the thresholds
+bool recordLogged = false;
+uint32_t loggedTime;                    // Time of the record (in ms)
+uint8_t loggedValid;
+int32_t loggedValues[channelCount];     // In the order of 'statisticsChannel'
+
+// -- Reading held back, written when the pressure door closes --
+// Only its time and its sensor readings are kept, it is written without GPS fix and statistics
+bool recordHeld = false;
+uint32_t heldTime;                      // Time of the reading (in ms)
+uint32_t heldTimestamp;                 // RTC time, see 'logRecord.timestamp'
+uint8_t heldValid;
+int32_t heldValues[channelCount];       // In the order of 'statisticsChannel'
+
+// Door of the last record, the rises are in Pa
+swingingDoor pressureDoor;
+
+// Time from the last record to 'time' (in s), at least 1
+uint32_t doorRun(uint32_t time) {
+    return max((time - loggedTime) / 1000, 1UL);
+}
+
+// Pressure of 'currentRecord' above the last record (in Pa)
+int32_t pressureRise() {
+    return (int32_t)currentRecord.pressure - loggedValues[pressure_channel];
+}
+
+// -- Narrows the door to the pressure of 'currentRecord' read at 'time' --
+// Returns false, leaving the door unchanged, if the reading closes it
+bool narrowPressureDoor(uint32_t time) {
+    return narrowDoor(pressureDoor, pressureRise(), doorRun(time), currentSystemConfiguration.DEADBAND_PRESSURE);
+}
+
+// The pressure is compressed while it is valid in both the last record and the current reading
+bool pressureTracked() {
+    return recordLogged && (loggedValid & currentRecord.valid & Pressure_valid);
+}
+
+// -- Makes 'currentRecord', read at 'time', the reference of the next readings --
+void setLoggedRecord(uint32_t time) {
+    recordLogged = true;
+    loggedTime = time;
+    loggedValid = currentRecord.valid;
+    for (unsigned char channel = 0; channel < channelCount; channel++) {
+        loggedValues[channel] = recordValue(channel);
+    }
+    pressureDoor.open = false;
+}
+
+// -- Writes 'currentRecord', read at 'time', and makes it the reference of the next readings --
+// Its pressure is moved onto the door for the file, and put back afterwards for the serial report
+void writeLoggedRecord(uint32_t time) {
+    uint32_t pressure = currentRecord.pressure;
+    if (pressureTracked()) {
+        currentRecord.pressure = loggedValues[pressure_channel] + riseOnDoor(pressureDoor, pressureRise(), doorRun(time));
+    }
+
+    writeRecord();
+    setLoggedRecord(time);
+    currentRecord.pressure = pressure;
+}
+
+// Swaps two blocks of memory of the same size
+void swapBytes(void* a, void* b, size_t size) {
+    unsigned char* bytesA = (unsigned char*)a;
+    unsigned char* bytesB = (unsigned char*)b;
+    for (size_t i = 0; i < size; i++) {
+        unsigned char byte = bytesA[i];
+        bytesA[i] = bytesB[i];
+        bytesB[i] = byte;
+    }
+}
+
+// Exchanges the readings of 'currentRecord' with the held back ones
+void swapHeldReading() {
+    for (unsigned char channel = 0; channel < channelCount; channel++) {
+        int32_t value = recordValue(channel);
+        setRecordValue(channel, heldValues[channel]);
+        heldValues[channel] = value;
+    }
+    swapBytes(&currentRecord.timestamp, &heldTimestamp, sizeof(heldTimestamp));
+    swapBytes(&currentRecord.valid, &heldValid, sizeof(heldValid));
+}
+
+// -- Writes the reading held back, if any --
+// Also called by 'switchMode()', so the trace of a mode ends with its last reading
+void writeHeldRecord() {
+    if (!recordHeld) {
+        return;
+    }
+    recordHeld = false;
+
+    if (!fileOpen) {
+        return;
+    }
+
+    // 'currentRecord' is lent to the held back reading, which shows N/A as GPS
+    bool responding = recordGPSresponding;
+    recordGPSresponding = false;
+    swapHeldReading();
+
+    writeLoggedRecord(heldTime);
+
+    swapHeldReading();
+    recordGPSresponding = responding;
+}
+
+// True if 'currentRecord', read at 'time', has to be written, see 'Deadband logging'
+bool recordChanged(uint32_t time) {
+    if (!recordLogged || (currentRecord.valid & Rate_changed)) {
+        return true;
+    }
+    if (time - loggedTime >= minutesToMs(currentSystemConfiguration.MAX_SILENCE)) {
+        return true;
+    }
+
+    const unsigned char channelMask = Temperature_valid | Humidity_valid | Pressure_valid | Light_valid;
+    if ((currentRecord.valid ^ loggedValid) & channelMask) {
+        return true;
+    }
+
+    // In the order of 'statisticsChannel', the pressure is left to the swinging door
+    const int32_t thresholds[channelCount] = {
+        (int32_t)currentSystemConfiguration.DEADBAND_TEMP * 10,
+        (int32_t)currentSystemConfiguration.DEADBAND_HYGR * 10,
+        -1,
+        currentSystemConfiguration.DEADBAND_LIGHT
+    };
+    for (unsigned char channel = 0; channel < channelCount; channel++) {
+        if (thresholds[channel] < 0 || !(currentRecord.valid & channelFlag(channel))) {
+            continue;
+        }
+        if (abs(recordValue(channel) - loggedValues[channel]) > thresholds[channel]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// -- Writes 'currentRecord' if it changed, holds it back otherwise --
+void logChanges() {
+    uint32_t now = schedulerTime();
+
+    // The reading held back is the last one a line from the last record still fits
+    if (pressureTracked() && !narrowPressureDoor(now)) {
+        writeHeldRecord();
+
+        // A door with a single reading is always open. Without a reading held back, it restarts from this one
+        pressureDoor.open = false;
+        if (pressureTracked()) {
+            narrowPressureDoor(now);
+        }
+    }
+
+    if (recordChanged(now)) {
+        writeLoggedRecord(now);
+        recordHeld = false;
+        return;
+    }
+
+    for (unsigned char channel = 0; channel < channelCount; channel++) {
+        heldValues[channel] = recordValue(channel);
+    }
+    heldTimestamp = currentRecord.timestamp;
+    heldValid = currentRecord.valid & ~(GPS_valid | Statistics_record);
+    heldTime = now;
+    recordHeld = true;
+}
+
+// -- LOG task --
+// The sensor tasks keep their latest sample in 'currentRecord', the LOG task adds the time and the GPS fix
+// and writes it, with the statistics of the interval if STATISTICS is set. The SD card is not used in maintenance mode
+
+uint16_t logTask() {
+    // Log the BME280 conversion started in the same period
+    if (BMEconverting) {
+        return BMEpollTime;
+    }
+
+    bool toFile = currentMode == standard || currentMode == economic;
+    if (toFile) {
+        selectFile();
+    }
+
+    // The last GPS check holds until the next one is due, in economic mode it covers two records.
+    // It is only stale once no GGA sentence came in for a whole GPS period and the TIMEOUT
+    if (millis() - lastGGAtime >= taskPeriod(GPS_task) + currentSystemConfiguration.TIMEOUT) {
+        GPSresponding = false;
+    }
+    readGPS();
+    recordGPSresponding = GPSresponding;
+
+    currentRecord.valid &= ~RTC_valid;
+    if (RTCpresent) {
+        readClock();
+        currentRecord.timestamp = currentTime();
+        currentRecord.valid |= RTC_valid;
+    }
+    readingCount++;
+
+    currentRecord.valid &= ~Statistics_record;
+    if (statisticsLogging()) {
+        summarizeChannels();
+        currentRecord.valid |= Statistics_record;
+    }
+
+    // -- Sampling rate change --
+    // A line of its own in text LOG files, a flag of the next record in binary ones
+    currentRecord.valid &= ~Rate_changed;
+    if (rateChanged) {
+        rateChanged = false;
+        currentRecord.valid |= Rate_changed;
+
+        if (toFile && !binaryLogging()) {
+            writeRateEvent(logPrint);
+        }
+        writeRateEvent(Serial);
+    }
+
+    if (toFile) {
+        if (deadbandLogging()) {
+            logChanges();
+        }
+        else {
+            writeRecord();
+        }
+    }
+
+    startTask(report_task, 0);
+    return taskDone;
+}
+
+// -- Serial reporter task --
+// Sends the record just logged to the serial monitor, with the revision and size of the current LOG file
+uint16_t reportTask() {
+    writeRecordText(Serial);
+
+    if (currentMode == standard || currentMode == economic) {
+        // Print file name
+        Serial.print(F("R : "));
+        Serial.println(currentLogFile.revision);
+
+        // Print file size
+        Serial.print(F("S : "));
+        Serial.print(currentFileSize());
+        Serial.println(F(" B"));
+        Serial.println();
+    }
+    return taskDone;
+}
+
+// -- SD flusher task --
+uint16_t flushTask() {
+    flushLogBuffer();
+    return taskDone;
+}
+
+// -- LED animator task --
+// While a button is held, the LED alternates between the colors of the current and of the next mode
+#define LEDblinkTime 500
+
+bool LEDshowsNextMode = false;
+
+uint16_t LEDtask() {
+    if (nextMode == noMode) {
+        LEDshowsNextMode = false;
+        setLEDcolor(getColor(modeColor(currentMode)));
+        return taskDone;
+    }
+
+    LEDshowsNextMode = !LEDshowsNextMode;
+    setLEDcolor(getColor(modeColor(LEDshowsNextMode ? nextMode : currentMode)));
+    return LEDblinkTime;
+}
+
+// In the order of 'taskID'
+const taskFunction taskFunctions[taskCount] PROGMEM = {GPStask, RTCtask, lightTask, BMEtask, tendencyTask, logTask, reportTask, flushTask, LEDtask};
+
+// -- Starts the tasks of the current mode --
+// Called by 'switchMode()', the tasks counted in LOG_INTERVALL run right away.
+// Tasks with a period in seconds that were already running keep their schedule, so e.g. the pressure
+// history stays evenly spaced. The statistics start over with the first LOG interval of the mode,
+// and its first reading is always written
+void startModeTasks() {
+    clearChannelStatistics();
+    recordLogged = false;
+
+    for (unsigned char task = 0; task < taskCount; task++) {
+        uint16_t period = taskPolicy(task);
+
+        if (period == onDemand) {
+            activeTasks &= ~(1 << task);
+            waitingTasks &= ~(1 << task);
+        }
+        else if ((period & logIntervalPeriod) || !taskActive((taskID)task)) {
+            startTask((taskID)task, 0);
+        }
+    }
+}
+
+// -- Runs every task whose deadline has passed, in the order of 'taskID' --
+void runDueTasks() {
+    for (unsigned char task = 0; task < taskCount; task++) {
+        uint16_t mask = 1 << task;
+        if (!(activeTasks & mask) || !deadlineReached(tasks[task].deadline)) {
+            continue;
+        }
+
+        uint32_t period = taskPeriod(task);
+
+        // A new period is counted from the deadline, so the readings do not drift,
+        // unless the task is more than a period late
+        if (!(waitingTasks & mask)) {
+            tasks[task].nextPeriod = tasks[task].deadline + period;
+            if (deadlineReached(tasks[task].nextPeriod)) {
+                tasks[task].nextPeriod = deadlineIn(period);
+            }
+        }
+
+        taskFunction function = (taskFunction)pgm_read_ptr(&taskFunctions[task]);
+        uint16_t wait = function();
+
+        if (wait != taskDone) {
+            tasks[task].deadline = deadlineIn(wait);
+            waitingTasks |= mask;
+        }
+        else {
+            tasks[task].deadline = tasks[task].nextPeriod;
+            waitingTasks &= ~mask;
+
+            // On demand tasks stop until started again
+            if (period == 0) {
+                activeTasks &= ~mask;
+            }
+        }
+    }
+}
+
+// -- Earliest deadline of the active tasks, false if no task is active --
+bool nextTaskDeadline(uint32_t now, uint32_t& deadline) {
+    bool found = false;
+
+    for (unsigned char task = 0; task < taskCount; task++) {
+        if (!(activeTasks & (1 << task))) {
+            continue;
+        }
+
+        deadline = found ? earliestDeadline(now, deadline, tasks[task].deadline) : tasks[task].deadline;
+        found = true;
+    }
+    return found;
+}
+
+
+/**
 =================================================== \n
-====================== GPS Stuff ===================== \n
+================== Configuration Mode ================== \n
 ===================================================
 */
 
-// Open SoftSerial for GPS
-SoftwareSerial SoftSerial(RX, TX);
+// Value of the command being executed, the text after '=' on the command line
+const char* commandArgument = "";
 
-bool timeout_GPS = false;
+// Set if the command line contains '=', without it a parameter command prints the current value
+bool commandHasArgument = false;
 
-void readGPS(String& output) {
-    if (SoftSerial.available()) // Check if soft serial is open
-    {
-        unsigned long timer = millis() + currentSystemConfiguration.TIMEOUT;
+// Used to send error messages when input values are not allowed by the command
+// 'command' is either a parameter name or an F() text
+template <typename text>
+void configValueError(text command, long value) {
+    Serial.print(F("Err "));
+    Serial.print(command);
+    Serial.print(F(" : "));
+    Serial.println(value);
+}
 
-        while(millis() < timer) {
-            output = SoftSerial.readStringUntil('\n');
+// -- Config parameters --
+// Every parameter of 'configuration' that can be set is described by one line of 'configParameters',
+// which is kept in flash and handled by 'setConfigParameter()'
 
-            output.trim();
+// Size and sign of a parameter in 'configuration', bool parameters are uint8Type from 0 to 1
+enum configType {uint8Type, uint16Type, int16Type};
 
-            if (output.startsWith("$GPGGA",0)){
-                timeout_GPS = false;
-                output+=valueSeparator;
-                writeTocurrentFile(output, false);
-                return;
-            }
-        }
-        if (timeout_GPS) {
-            criticalError(GPS_error);
-        }
+// Bits of 'configParameter.flags'
+enum configFlag {
+    persistFlag = 1,        // Written to EEPROM when changed
+    powerOfTwoFlag = 2,     // Has to be 0 or a power of two
+    GPSflag = 4             // Sent to the GPS when changed
+};
 
-        timeout_GPS = true;
-        output = "N/A";
-        output+=valueSeparator;
-        writeTocurrentFile(output, false);
-        return;
-    }
-    else {
-        criticalError(GPS_error);
+struct configParameter {
+    char name[17];
+    unsigned char offset;   // offsetof() the parameter in 'configuration'
+    unsigned char type;     // See 'configType'
+    int minimum;
+    unsigned int maximum;
+    unsigned char flags;    // See 'configFlag'
+};
+
+#define configEntry(name, field, type, minimum, maximum, flags) {name, offsetof(configuration, field), type, minimum, maximum, flags}
+
+const configParameter configParameters[] PROGMEM = {
+    configEntry("LUMIN",            ACTIVATE_LUMINOSITY_SENSOR,     uint8Type,  0,      1,      persistFlag),
+    configEntry("LUMIN_LOW",        LUMINOSITY_LOW_THRESHOLD,       uint16Type, 0,      1023,   persistFlag),
+    configEntry("LUMIN_HIGH",       LUMINOSITY_HIGH_THRESHOLD,      uint16Type, 0,      1023,   persistFlag),
+    configEntry("TEMP_AIR",         ACTIVATE_THERMOMETER,           uint8Type,  0,      1,      persistFlag),
+    configEntry("MIN_TEMP_AIR",     THERMOMETER_MIN_TEMPERATURE,    int16Type,  -40,    85,     persistFlag),
+    configEntry("MAX_TEMP_AIR",     THERMOMETER_MAX_TEMPERATURE,    int16Type,  -40,    85,     persistFlag),
+    configEntry("HYGR",             ACTIVATE_HYGROMETRY_SENSOR,     uint8Type,  0,      1,      persistFlag),
+    configEntry("HYGR_MINT",        MIN_TEMPERATURE_FOR_HYGROMETRY, int16Type,  -40,    85,     persistFlag),
+    configEntry("HYGR_MAXT",        MAX_TEMPERATURE_FOR_HYGROMETRY, int16Type,  -40,    85,     persistFlag),
+    configEntry("PRESSURE",         ACTIVATE_PRESSURE_SENSOR,       uint8Type,  0,      1,      persistFlag),
+    configEntry("PRESSURE_MIN",     MIN_VALID_PRESSURE,             uint16Type, 300,    1100,   persistFlag),
+    configEntry("PRESSURE_MAX",     MAX_VALID_PRESSURE,             uint16Type, 300,    1100,   persistFlag),
+    configEntry("LOG_INTERVALL",    LOG_INTERVALL,                  uint8Type,  1,      255,    persistFlag),
+    configEntry("FILE_MAX_SIZE",    FILE_MAX_SIZE,                  uint16Type, 512,    65535,  persistFlag),
+    configEntry("TIMEOUT",          TIMEOUT,                        uint16Type, 1000,   60000,  persistFlag),
+    configEntry("LOG_FORMAT",       LOG_FORMAT,                     uint8Type,  0,      1,      persistFlag),
+    configEntry("PREALLOCATE",      PREALLOCATE,                    uint8Type,  0,      1,      persistFlag),
+    configEntry("OVERSAMPLING_STD", STANDARD_OVERSAMPLING,          uint8Type,  1,      16,     persistFlag | powerOfTwoFlag),
+    configEntry("FILTER_STD",       STANDARD_FILTER,                uint8Type,  0,      16,     persistFlag | powerOfTwoFlag),
+    configEntry("OVERSAMPLING_ECO", ECONOMIC_OVERSAMPLING,          uint8Type,  1,      16,     persistFlag | powerOfTwoFlag),
+    configEntry("FILTER_ECO",       ECONOMIC_FILTER,                uint8Type,  0,      16,     persistFlag | powerOfTwoFlag),
+    configEntry("GPS_RAW",          GPS_RAW,                        uint8Type,  0,      1,      persistFlag),
+    configEntry("GPS_SENTENCES",    GPS_SENTENCES,                  uint8Type,  0,      63,     persistFlag | GPSflag),
+    configEntry("GPS_RATE",         GPS_RATE,                       uint16Type, 100,    10000,  persistFlag | GPSflag),
+    configEntry("GPS_STANDBY",      GPS_STANDBY,                    uint8Type,  0,      2,      persistFlag),
+    configEntry("GPS_WARMUP",       GPS_WARMUP,                     uint8Type,  1,      255,    persistFlag),
+    configEntry("CLOCK_SYNC",       CLOCK_SYNC,                     uint8Type,  0,      1,      persistFlag),
+    configEntry("POWER_DOWN",       POWER_DOWN,                     uint8Type,  0,      1,      persistFlag),
+    configEntry("TENDENCY_FALL",    TENDENCY_FALL,                  uint8Type,  0,      255,    persistFlag),
+    configEntry("STATISTICS",       STATISTICS,                     uint8Type,  0,      1,      persistFlag),
+    configEntry("SAMPLE_PERIOD",    SAMPLE_PERIOD,                  uint8Type,  1,      255,    persistFlag),
+    configEntry("DEADBAND",         DEADBAND,                       uint8Type,  0,      1,      persistFlag),
+    configEntry("DEADBAND_TEMP",    DEADBAND_TEMP,                  uint8Type,  0,      255,    persistFlag),
+    configEntry("DEADBAND_HYGR",    DEADBAND_HYGR,                  uint8Type,  0,      255,    persistFlag),
+    configEntry("DEADBAND_PRESS",   DEADBAND_PRESSURE,              uint8Type,  0,      255,    persistFlag),
+    configEntry("DEADBAND_LUMIN",   DEADBAND_LIGHT,                 uint8Type,  0,      255,    persistFlag),
+    configEntry("MAX_SILENCE",      MAX_SILENCE,                    uint8Type,  1,      255,    persistFlag),
+};
+
+#define configParameterCount (sizeof(configParameters) / sizeof(configParameter))
+
+// -- Prints the current value of a parameter --
+void printConfigParameter(const configParameter& parameter) {
+    const unsigned char* field = (const unsigned char*)&currentSystemConfiguration + parameter.offset;
+
+    Serial.print(parameter.name);
+    Serial.print(F(" = "));
+    switch (parameter.type) {
+        case uint8Type:
+            Serial.println(*field);
+            break;
+        case uint16Type:
+            Serial.println(*(const uint16_t*)field);
+            break;
+        case int16Type:
+            Serial.println(*(const int16_t*)field);
+            break;
     }
 }
 
-/**
-=================================================== \n
-==================== Perform reading =================== \n
-===================================================
-*/
+// -- Reads a decimal number, e.g. '-12' --
+// Returns the end of the number, nullptr if 'text' does not start with one
+const char* parseNumber(const char* text, long& value) {
+    bool negative = *text == '-';
+    if (negative) {
+        text++;
+    }
+    if (!isdigit(*text)) {
+        return nullptr;
+    }
 
-void performReading() {
-    selectFile();
+    value = 0;
+    while (isdigit(*text) && value < 1000000L) {
+        value = value * 10 + (*text++ - '0');
+    }
+    if (negative) {
+        value = -value;
+    }
+    return text;
+}
 
-    // -- GPS reading --
-    // Only called every second execution if in economic mode
-    if (readGPSnextExec) {
-        readGPS(dataString);
+// -- Reads 'count' numbers separated by ':', e.g. '12:30:00' --
+// Returns false if the argument is anything else
+bool parseNumbers(long* values, unsigned char count) {
+    const char* text = commandArgument;
+    for (unsigned char i = 0; i < count; i++) {
+        if (i > 0 && *text++ != ':') {
+            return false;
+        }
+        text = parseNumber(text, values[i]);
+        if (text == nullptr) {
+            return false;
+        }
     }
+    return *text == '\0';
+}
 
-    // Toggle whether the GPS is read next execution if in economic mode
-    if (currentMode == economic) {
-        readGPSnextExec = !readGPSnextExec;
+// -- Sets a parameter to the value of the command line, returns false if the value is not allowed --
+bool setConfigParameter(const configParameter& parameter) {
+    long value = 0;
+    bool valid = parseNumbers(&value, 1) && value >= parameter.minimum && value <= (long)parameter.maximum;
+    if (valid && (parameter.flags & powerOfTwoFlag)) {
+        valid = (value & (value - 1)) == 0;
     }
 
-    // -- RTC Clock reading --
-    readTime(dataString);
+    if (!valid) {
+        configValueError(parameter.name, value);
+        return false;
+    }
 
-    // -- Luminosity captor reading --
-    readLightSensorData(dataString);
+    unsigned char* field = (unsigned char*)&currentSystemConfiguration + parameter.offset;
+    switch (parameter.type) {
+        case uint8Type:
+            *field = value;
+            break;
+        case uint16Type:
+            *(uint16_t*)field = value;
+            break;
+        case int16Type:
+            *(int16_t*)field = value;
+            break;
+    }
 
-    //-- BME280 Readings --
-    readBMEdata(dataString);
+    if (parameter.flags & GPSflag) {
+        configureGPS();
+    }
+    // Saved to the next config slot, see 'EEPROM Config'. Setting the value it already had writes nothing
+    if (parameter.flags & persistFlag) {
+        writeConfigToEEPROM();
+    }
+    return true;
 }
 
+// -- Config actions --
+// Commands that do not set a single parameter, they return false if the value is not allowed
 
-/**
-=================================================== \n
-================== Configuration Mode ================== \n
-===================================================
-*/
+// RESET
+bool resetConfig() {
+    defaultConfig();
+    configureGPS();
+    writeConfigToEEPROM();
+    return true;
+}
 
-// Set to true if the user has entered an incorrect value in config mode
-bool valueError = false;
+// CLOCK=HH:MM:SS
+bool setClock() {
+    long time[3];
 
-// Used to send error messages when input values are not allowed by the command
-void configValueError(const String& command, const int& value) {
-    Serial.print("Err " + command + " : ");
-    Serial.println(value);
-    valueError = true;
+    if (!parseNumbers(time, 3)) {
+        Serial.println(F("err"));
+        return false;
+    }
+    long hour = time[0], minute = time[1], second = time[2];
+    if (hour < 0 or hour > 23) {
+        configValueError(F("hr"), hour);
+        return false;
+    }
+    if (minute < 0 or minute > 59) {
+        configValueError(F("min"), minute);
+        return false;
+    }
+    if (second < 0 or second > 59) {
+        configValueError(F("sec"), second);
+        return false;
+    }
+
+    // Write values to RTC, the date is kept
+    readClock();
+    clock.fillByHMS(hour, minute, second);
+    clock.setTime();
+    syncClockFromRTC();
+    return true;
 }
 
-// Array of functions containing one function per supported config command
-void (*configFunctions[])(const String& command) = {
-        // LUMIN
-        [](const String& command) -> void
-        {
-            // Parse value from Serial
-            int value = Serial.parseInt();
+// DATE=MM:DD:YYYY
+bool setDate() {
+    long date[3];
 
-            // Command Logic
-            if (value != 1 and value != 0) {
-                configValueError(command, value);
-                return;
-            }
+    if (!parseNumbers(date, 3)) {
+        Serial.println(F("err"));
+        return false;
+    }
+    long month = date[0], day = date[1], year = date[2];
+    if (month < 1 or month > 12) {
+        configValueError(F("mth"), month);
+        return false;
+    }
+    if (day < 1 or day > 31) {
+        configValueError(F("dy"), day);
+        return false;
+    }
+    if (year < 2000 or year > 2099) {
+        configValueError(F("yr"), year);
+        return false;
+    }
 
-            // Write changes to config
-            currentSystemConfiguration.ACTIVATE_LUMINOSITY_SENSOR = (value == 1);
-        },
+    // Write values to RTC, the time is kept
+    readClock();
+    clock.fillByYMD(year, month, day);
+    clock.setTime();
+    syncClockFromRTC();
+    return true;
+}
 
-        // LUMIN_LOW
-        [](const String& command) -> void
-        {
-            // Parse value from Serial
-            int value = Serial.parseInt();
+// DAY=1 (monday) - 7 (sunday)
+// The day of the week is also recalculated from the date whenever the RTC is set
+bool setDayOfWeek() {
+    long value = 0;
 
-            // Command Logic
-            if (0 <= value and value >= 1023) {
-                // Write changes to config
-                currentSystemConfiguration.LUMINOSITY_LOW_THRESHOLD = value;
-            }
-            else {
-                configValueError(command, value);
-            }
-        },
-
-        // LUMIN_HIGH
-        [](const String& command) -> void
-        {
-            // Parse value from Serial
-            int value = Serial.parseInt();
-
-            // Command Logic
-            if (0 <= value and value >= 1023) {
-                // Write changes to config
-                currentSystemConfiguration.LUMINOSITY_HIGH_THRESHOLD = value;
-            }
-            else {
-                configValueError(command, value);
-            }
-        },
-
-        // TEMP_AIR
-        [](const String& command) -> void
-        {
-            // Parse value from Serial
-            int value = Serial.parseInt();
-
-            // Command Logic
-            if (value != 1 and value != 0) {
-                configValueError(command, value);
-                return;
-            }
+    if (!parseNumbers(&value, 1) || value < 1 or value > 7) {
+        configValueError(F("DAY"), value);
+        return false;
+    }
 
-            // Write changes to config
-            currentSystemConfiguration.ACTIVATE_THERMOMETER = (value == 1);
+    readClock();
+    clock.fillDayOfWeek(value);
+    clock.setTime();
+    return true;
+}
 
-        },
+// -- Runs a config command, returns false if 'name' is none --
+// Only available in config mode
+bool runConfigCommand(const char* name) {
+    static const char configActions[][6] PROGMEM = {"RESET", "CLOCK", "DATE", "DAY"};
+    typedef bool (*configAction)();
+    static const configAction configActionFunctions[] PROGMEM = {resetConfig, setClock, setDate, setDayOfWeek};
+
+    bool executed = false;
+    bool found = false;
+
+    for (unsigned char i = 0; i < configParameterCount && !found; i++) {
+        if (strcmp_P(name, configParameters[i].name) == 0) {
+            configParameter parameter;
+            memcpy_P(&parameter, &configParameters[i], sizeof(configParameter));
+            found = true;
+
+            if (!commandHasArgument) {
+                printConfigParameter(parameter);
+                return true;
+            }
+            executed = setConfigParameter(parameter);
+        }
+    }
 
-        // MIN_TEMP_AIR
-        [](const String& command) -> void
-        {
-            // Parse value from Serial
-            int value = Serial.parseInt();
+    for (unsigned char i = 0; i < 4 && !found; i++) {
+        if (strcmp_P(name, configActions[i]) == 0) {
+            found = true;
+            executed = ((configAction)pgm_read_ptr(&configActionFunctions[i]))();
+        }
+    }
 
-            // Command Logic
-            if (-40 <= value and value >= 85) {
-                // Write changes to config
-                currentSystemConfiguration.THERMOMETER_MIN_TEMPERATURE = value;
-            }
-            else {
-                configValueError(command, value);
-            }
+    if (executed) {
+        Serial.print(name);
+        Serial.println(F(" executed"));
+    }
+    return found;
+}
 
-        },
 
-        // MAX_TEMP_AIR
-        [](const String& command) -> void
-        {
-            // Parse value from Serial
-            int value = Serial.parseInt();
+/**
+=================================================== \n
+========================= Sleep ======================== \n
+===================================================
+*/
 
-            // Command Logic
-            if (-40 <= value and value >= 85) {
-                // Write changes to config
-                currentSystemConfiguration.THERMOMETER_MAX_TEMPERATURE = value;
-            }
-            else {
-                configValueError(command, value);
-            }
+// Between two events the MCU sleeps instead of polling millis().
+// Idle mode only stops the CPU, any interrupt wakes it up : the millis() timer every ms, the serial port,
+// the SoftwareSerial pin of the GPS and the buttons, so nothing is missed.
+// Power-down also stops the timers and the serial port. It is only used in standard and economic mode
+// while the GPS is in standby or missing, the watchdog then wakes the MCU up before the next deadline.
+// The DS1307's square wave output is not wired to the Arduino, so it can not be used as a wake-up source
 
-        },
+// Power-down is not used before this time, see 'stayAwakeTime'
+uint32_t stayAwakeTimer = 0;
 
-        // HYGR
-        [](const String& command) -> void
-        {
-            // Parse value from Serial
-            int value = Serial.parseInt();
+// Set by the watchdog interrupt, tells a watchdog wake-up from a pin change one
+volatile bool watchdogWoke = false;
 
-            // Command Logic
-            if (value != 1 and value != 0) {
-                configValueError(command, value);
-                return;
-            }
-            // Write changes to config
-            currentSystemConfiguration.ACTIVATE_HYGROMETRY_SENSOR = (value == 1);
-        },
-
-        // HYGR_MINT
-        [](const String& command) -> void
-        {
-            // Parse value from Serial
-            int value = Serial.parseInt();
-
-            // Command Logic
-            if (-40 <= value and value >= 85) {
-                // Write changes to config
-                currentSystemConfiguration.MIN_TEMPERATURE_FOR_HYGROMETRY = value;
-            }
-            else {
-                configValueError(command, value);
-            }
-        },
-
-        // HYGR_MAXT
-        [](const String& command) -> void
-        {
-            // Parse value from Serial
-            int value = Serial.parseInt();
-
-            // Command Logic
-            if (-40 <= value and value >= 85) {
-                // Write changes to config
-                currentSystemConfiguration.MAX_TEMPERATURE_FOR_HYGROMETRY = value;
-            }
-            else {
-                configValueError(command, value);
-            }
-        },
-
-        // PRESSURE
-        [](const String& command) -> void
-        {
-            // Parse value from Serial
-            int value = Serial.parseInt();
-
-            // Command Logic
-            if (value != 1 and value != 0) {
-                configValueError(command, value);
-                return;
-            }
+ISR(WDT_vect) {
+    watchdogWoke = true;
+}
 
-            // Write changes to config
-            currentSystemConfiguration.ACTIVATE_PRESSURE_SENSOR = (value == 1);
+// Millisecond counter of the Arduino core, advanced by the time spent in power-down
+extern volatile unsigned long timer0_millis;
 
-        },
+bool powerDownAllowed() {
+    return currentSystemConfiguration.POWER_DOWN
+        && (currentMode == standard || currentMode == economic)
+        && nextMode == noMode
+        && (GPSasleep || !GPSpresent)
+        && deadlineReached(stayAwakeTimer);
+}
 
-        // PRESSURE_MIN
-        [](const String& command) -> void
-        {
-            // Parse value from Serial
-            int value = Serial.parseInt();
+// -- Powers the MCU down for one watchdog period --
+// A button or the serial port wake it up earlier through their pin change interrupts
+void powerDown(int8_t prescaler) {
+    // Let the last serial output leave before the UART stops
+    Serial.flush();
+
+    // Buttons (PCINT18, PCINT19) and serial RX (PCINT16). The handler of these pin change interrupts
+    // belongs to SoftwareSerial, it only looks at the GPS pin and ignores them
+    PCMSK2 |= _BV(PCINT16) | _BV(PCINT18) | _BV(PCINT19);
+    PCIFR = _BV(PCIF2);
+    PCICR |= _BV(PCIE2);
+
+    // Watchdog in interrupt mode, WDP3 is not next to the other prescaler bits
+    unsigned char watchdogPrescalerBits = (prescaler & 7) | ((prescaler & 8) ? _BV(WDP3) : 0);
+    watchdogWoke = false;
+    noInterrupts();
+    wdt_reset();
+    WDTCSR = _BV(WDCE) | _BV(WDE);
+    WDTCSR = _BV(WDIE) | watchdogPrescalerBits;
 
-            // Command Logic
-            if (300 <= value and value >= 1100) {
-                // Write changes to config
-                currentSystemConfiguration.MIN_VALID_PRESSURE = value;
-            }
-            else {
-                configValueError(command, value);
-            }
-        },
-
-        // PRESSURE_MAX
-        [](const String& command) -> void
-        {
-            // Parse value from Serial
-            int value = Serial.parseInt();
-
-            // Command Logic
-            if (300 <= value and value >= 1100) {
-                // Write changes to config
-                currentSystemConfiguration.MAX_VALID_PRESSURE = value;
-            }
-            else {
-                configValueError(command, value);
-            }
-        },
-
-        // LOG_INTERVALL
-        [](const String& command) -> void
-        {
-            // Parse value from Serial
-            int value = Serial.parseInt();
-
-            // Command Logic
-            if (0 < value and value >= 255) {
-                // Write changes to config
-                currentSystemConfiguration.LOG_INTERVALL = value;
-            }
-            else {
-                configValueError(command, value);
-            }
-        },
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
+    // The instruction following 'sei' is always executed, so no interrupt can slip in before the sleep
+    interrupts();
+    sleep_cpu();
+    sleep_disable();
 
-        // FILE_MAX_SIZE
-        [](const String& command) -> void
-        {
-            // Parse value from Serial
-            int value = Serial.parseInt();
+    wdt_disable();
+    PCICR &= ~_BV(PCIE2);
+    PCMSK2 &= ~(_BV(PCINT16) | _BV(PCINT18) | _BV(PCINT19));
 
-            // Command Logic
-            if (100 < value and value >= 65535) {
-                currentSystemConfiguration.FILE_MAX_SIZE = value;
-            }
-            else {
-                configValueError(command, value);
-            }
-        },
+    if (watchdogWoke) {
+        noInterrupts();
+        timer0_millis += watchdogPeriod(prescaler);
+        interrupts();
+    }
+    else {
+        // Woken up by a button or the serial port, the time slept is unknown and counted as 0.
+        // The buttons' CHANGE interrupts only see edges while the MCU runs, so their state is read again
+        stayAwakeTimer = deadlineIn(stayAwakeTime);
+        greenButtonInterrupt();
+        redButtonInterrupt();
+    }
 
-        // RESET
-        [](const String& command) -> void
-        {
-            defaultConfig();
-        },
+    // The watchdog is only accurate to about 10 %, the software clock is re-anchored from the RTC at the next reading
+    clockAnchored = false;
+}
 
-        // TIMEOUT
-        [](const String& command) -> void
-        {
-            // Parse value from Serial
-            int value = Serial.parseInt();
+// -- Sleeps until the next interrupt, or in power-down until close to the next deadline --
+void sleepUntilNextEvent() {
+    uint32_t now = schedulerTime();
+    uint32_t nextEvent;
+    bool scheduled = nextTaskDeadline(now, nextEvent);
 
-            // Command Logic
-            if (0 <= value and value >= 255) {
-                currentSystemConfiguration.TIMEOUT = value;
-            }
-            else {
-                configValueError(command, value);
-            }
-        },
+    // The GPS is woken up GPS_WARMUP seconds before the GPS task
+    if (scheduled && GPSasleep && taskActive(GPS_task)) {
+        nextEvent = earliestDeadline(now, nextEvent, GPSwakeTime());
+    }
 
-        // CLOCK
-        [](const String& command) -> void
-        {
-            String HHMMSS = Serial.readString();
+    int8_t prescaler = scheduled ? watchdogPrescaler(timeUntil(now, nextEvent)) : noWatchdogPeriod;
+    if (prescaler != noWatchdogPeriod && powerDownAllowed()) {
+        powerDown(prescaler);
+        return;
+    }
 
-            unsigned char hour, minute, second;
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_mode();
+}
 
-            if (sscanf(HHMMSS.c_str(), "%s:%s:%s", &hour, &minute, &second) == 3) {
-                if (hour < 0 or hour > 23) {
-                    configValueError("hr", hour);
-                    return;
-                }
-                if (minute < 0 or minute > 59) {
-                    configValueError("min", minute);
-                    return;
-                }
-                if (second < 0 or second > 59) {
-                    configValueError("sec", second);
-                    return;
-                }
+/**
+=================================================== \n
+==================== Serial commands =================== \n
+===================================================
+*/
 
-                // Write values to RTC
-                clock.fillByHMS(hour, minute, second);
-                clock.setTime();
-            }
-            else {
-                Serial.println("err");
-            }
-        },
-
-        // DATE
-        [](const String& command) -> void
-        {
-            String MMDDYY = Serial.readString();
-            unsigned char month, day;
-            int year;
-
-            if (sscanf(MMDDYY.c_str(), "%s:%s:%d", &month, &day, &year) == 3) {
-                if (month < 1 or month > 12) {
-                    configValueError("mth", month);
-                    return;
-                }
-                if (day < 1 or day > 31) {
-                    configValueError("dy", day);
-                    return;
-                }
-                if (year < 2000 or year > 2099) {
-                    configValueError("yr", year);
-                    return;
-                }
+// -- Read only commands --
+// Available in every mode, they never interrupt logging
 
-                // Write values to RTC
-                clock.fillByHMS(month, day, year);
-                clock.setTime();
-            }
-            else {
-                Serial.println("err");
-            }
-        },
-
-        // DAY
-        [](const String& command) -> void
-        {
-            // Parse value from Serial
-            int value = Serial.parseInt();
-
-            // Command Logic
-            if (1 <= value and value >= 7) {
-                // Write value to RTC
-                clock.fillDayOfWeek(value);
-            }
-            else {
-                configValueError(command, value);
-            }
-            return;
-        },
+// STATUS : mode, current file, devices found at boot, age of the last fix, uptime and config slot
+void printStatus() {
+    static const char modeNames[][12] PROGMEM = {"STANDARD", "ECONOMIC", "MAINTENANCE", "CONFIG"};
 
-        // VERSION
-        [](const String& command) -> void
-        {
-            Serial.print(programVersion);
-            Serial.print(", ID ");
-            Serial.println(deviceID);
-        }
-};
+    Serial.print(F("MODE : "));
+    Serial.println(flashText(modeNames[currentMode]));
+
+    Serial.print(F("FILE : "));
+    if (fileOpen) {
+        Serial.print(fileName);
+        Serial.print(F(", "));
+        Serial.print(currentFileSize());
+        Serial.println(F(" B"));
+    }
+    else {
+        Serial.println(F("N/A"));
+    }
 
+    Serial.print(F("RTC BME GPS : "));
+    Serial.print(RTCpresent);
+    Serial.print(' ');
+    Serial.print(BMEpresent);
+    Serial.print(' ');
+    Serial.println(GPSpresent);
+
+    Serial.print(F("FIX : "));
+    if (fixCached) {
+        Serial.print((millis() - cachedFixTime) / 1000);
+        Serial.println(F(" s"));
+    }
+    else {
+        Serial.println(F("N/A"));
+    }
 
-// This mode is called by pressing the red button for 5s at the start of the programs execution
-void configMode() {
-    // Reset config mode timeout to 30 minutes
-    switchModeTimer = millis() + configTimeout;
+    // Pressure tendency over the last hour and the last 3 hours, and the current LOG interval
+    char* str = appendText(dataString, PSTR("TENDENCY : "));
+    str = appendText(appendTendency(str, shortTendencyKnown(), shortTendency), PSTR(", "));
+    str = appendText(appendTendency(str, longTendencyKnown(), longTendency), PSTR(", LOG every "));
+    appendText(appendNumber(str, logInterval() / 1000), PSTR(" s"));
+    Serial.println(dataString);
+
+    Serial.print(F("UP : "));
+    Serial.print(millis() / 1000);
+    Serial.println(F(" s"));
+
+    Serial.print(F("CONFIG : slot "));
+    Serial.print(configSlot);
+    Serial.print(F(", generation "));
+    Serial.println(configGeneration);
+}
 
-    // Array of supported commands
-    const char* configCommands[] = {"LUMIN", "LUMIN_LOW", "LUMIN_HIGH", "TEMP_AIR", "MIN_TEMP_AIR",
-                                    "MAX_TEMP_AIR", "HYGR", "HYGR_MINT", "HYGR_MAXT", "PRESSURE",
-                                    "PRESSURE_MIN", "PRESSURE_MAX", "LOG_INTERVALL", "FILE_MAX_SIZE",
-                                    "RESET", "TIMEOUT", "CLOCK", "DATE", "DAY", "VERSION"};
+// COUNTERS : readings, dropped NMEA sentences, RTC corrections and EEPROM writes since boot
+void printCounters() {
+    Serial.print(F("READINGS : "));
+    Serial.println(readingCount);
+    Serial.print(F("RECORDS WRITTEN : "));
+    Serial.println(recordsWritten);
+    Serial.print(F("NMEA ERRORS : "));
+    Serial.println(NMEAerrors);
+    Serial.print(F("CLOCK CORRECTIONS : "));
+    Serial.println(clockCorrections);
+
+    // EEPROM : updates, bytes written, time spent
+    Serial.print(F("EEPROM : "));
+    Serial.print(EEPROMupdates);
+    Serial.print(F(", "));
+    Serial.print(EEPROMbytesWritten);
+    Serial.print(F(" B, "));
+    Serial.print(EEPROMwriteTime / 1000);
+    Serial.println(F(" ms"));
+}
 
-    // String to store the user's input
-    String command = Serial.readStringUntil('=');
+// LAST : the latest samples with the time of the last reading, in the same layout as the text LOG files
+void printLastRecord() {
+    if (readingCount == 0) {
+        Serial.println(F("N/A"));
+        return;
+    }
 
-    // Remove any unwanted spaces or CR & LF symbols
-    command.trim();
+    writeRecordText(Serial);
+}
 
-    // Make the String upper case
-    command.toUpperCase();
+// VERSION : program version and device ID
+void printVersion() {
+    Serial.print(programVersion);
+    Serial.print(F(", ID "));
+    Serial.println(deviceID);
+}
 
-    // -- Interpretation of the users input --
-    int i = 0;
-    bool loop = true;
+// -- Runs a read only command, returns false if 'name' is none --
+bool runReadOnlyCommand(const char* name) {
+    static const char readOnlyCommands[][9] PROGMEM = {"STATUS", "COUNTERS", "LAST", "VERSION"};
+    typedef void (*readOnlyCommand)();
+    static const readOnlyCommand readOnlyFunctions[] PROGMEM = {printStatus, printCounters, printLastRecord, printVersion};
 
-    // Attempting to match the input to a supported configuration command
-    while(loop) {
-        if (i == 20) {
-            // If command is unknown, return to loop()
-            Serial.println("Unknown cmd");
-            return;
+    for (unsigned char i = 0; i < 4; i++) {
+        if (strcmp_P(name, readOnlyCommands[i]) == 0) {
+            ((readOnlyCommand)pgm_read_ptr(&readOnlyFunctions[i]))();
+            return true;
         }
+    }
+    return false;
+}
 
-        // Find command in list of supported commands
-        if (command == configCommands[i]) {
-            // Call function corresponding to command
-            configFunctions[i](command);
+// -- Incremental command line parser --
+// Characters are taken from Serial as they arrive and a command is only run once its line is complete,
+// so no command ever waits for the serial port. A line is "NAME" or "NAME=VALUE"
+#define maxCommandLength 32
+char commandLine[maxCommandLength + 1];
+unsigned char commandLength = 0;
+
+// Set when a line is longer than 'maxCommandLength', it is then ignored
+bool commandOverflow = false;
+
+// -- Runs a complete command line --
+void runCommandLine() {
+    commandLine[commandLength] = '\0';
+
+    // Split the line into the command name and its argument
+    char* argument = strchr(commandLine, '=');
+    commandHasArgument = argument != nullptr;
+    if (commandHasArgument) {
+        *argument++ = '\0';
+    }
+    else {
+        argument = commandLine + commandLength;
+    }
+    commandArgument = argument;
 
-            loop = false;
-        }
-        else {
-            i++;
-        }
+    // Remove any unwanted spaces and make the name upper case
+    char* name = commandLine;
+    while (*name == ' ') {
+        name++;
+    }
+    char* end = name + strlen(name);
+    while (end > name && end[-1] == ' ') {
+        end--;
+    }
+    *end = '\0';
+    for (char* c = name; *c; c++) {
+        *c = toupper(*c);
     }
 
-    // -- Flush data remaining in Serial to prevent errors --
-    Serial.readString();
+    if (*name == '\0') {
+        return;
+    }
 
-    // Return if an invalid value was entered
-    if (valueError) {
-        valueError = false;
+    if (runReadOnlyCommand(name)) {
         return;
     }
 
-    Serial.println(command + " executed");
+    if (currentMode == config) {
+        // Reset config mode timeout to 30 minutes
+        switchModeTimer = deadlineIn(configTimeout);
 
-    // -- Write config to EEPROM --
-    // Unfortunately the entire config gets written again each time, which hits EEPROM pretty hard
+        if (!runConfigCommand(name)) {
+            Serial.println(F("Unknown cmd"));
+        }
+    }
+    else {
+        Serial.println(F("Config mode only"));
+    }
+}
 
-    // Theoretically I could calculate the exact location of each element of my configuration struct in EEPROM and
-    // only change that, but it's too complicated and memory intensive for this project
+// -- Feeds the characters waiting in Serial to the command line parser --
+void pollSerial() {
+    while (Serial.available() > 0) {
+        char c = Serial.read();
 
-    // Only config commands 0 - 15 require writing to EEPROM
-    if (i < 16) {
-        writeConfigToEEPROM();
+        // Stay awake while a command is typed, the UART does not run in power-down
+        stayAwakeTimer = deadlineIn(stayAwakeTime);
+
+        if (c == '\r' || c == '\n') {
+            if (commandOverflow) {
+                Serial.println(F("Cmd too long"));
+            }
+            else if (commandLength > 0) {
+                runCommandLine();
+            }
+            commandLength = 0;
+            commandOverflow = false;
+        }
+        else if (commandLength < maxCommandLength) {
+            commandLine[commandLength++] = c;
+        }
+        else {
+            commandOverflow = true;
+        }
     }
 }
 
@@ -1098,14 +3502,26 @@ void configMode() {
 ===================================================
 */
 
-void setup() {
-    // -- Reserve space for Strings to avoid fragmentation --
-    // Contains sensor data
-    dataString.reserve(45);
+// -- Boot timeouts --
+#define I2Ctimeout 25000            // Longest I2C transfer (in µs)
+#define GPSbootTimeout 1000         // Time the GPS gets to answer after GPS_RATE (in ms)
+
+// -- Returns true if a device answers at an I2C address --
+bool I2Cpresent(uint8_t address) {
+    Wire.beginTransmission(address);
+    return Wire.endTransmission() == 0;
+}
 
-    // String for file name
-    fileName.reserve(13);
+// -- Boot report --
+// Prints the time a boot phase took, e.g. "GPS : 1012 ms N/A" for a device that did not answer
+void printBootPhase(const __FlashStringHelper* phase, unsigned long phaseStart, bool present) {
+    Serial.print(phase);
+    Serial.print(F(" : "));
+    Serial.print(millis() - phaseStart);
+    Serial.println(present ? F(" ms") : F(" ms N/A"));
+}
 
+void setup() {
     // -- Configure LEDs --
     leds.init();
 
@@ -1116,33 +3532,31 @@ void setup() {
     // -- Open serial communications and wait for port to open --
     Serial.begin(9600);
 
-    // -- Check whether the program has run before --
-    EEPROM.get(EEPROM_BOOL_programHasRunBefore, programHasRunBefore);
-
-    // programHasRunBefore = false;
-
-    if (programHasRunBefore) {
-        // If this is not the first time the program is running since the arduino was flashed
-        getConfigFromEEPROM();
+    // -- Load the configuration --
+    // The newest valid config slot, else the configuration of an older firmware, else the default one
+    if (getConfigFromEEPROM()) {
+        getLogFileFromEEPROM();
     }
     else {
         // If this is the first time the program is running since the arduino was flashed
-        defaultConfig();
-        writeConfigToEEPROM();
-        programHasRunBefore = true;
-        EEPROM.put(EEPROM_BOOL_programHasRunBefore, programHasRunBefore);
+        if (!migrateLegacyConfig()) {
+            defaultConfig();
+            writeConfigToEEPROM();
+        }
+        currentLogFile.revision = 0;
+        writeLogFileToEEPROM();
     }
 
     // -- Check if RED button is pressed for 5 sec, go to config systemMode if yes --
     // Reminder : the button is 'LOW' active
     if (!digitalRead(redButtonPIN)) {
-        unsigned long counter = millis() + buttonPressTime;
+        uint32_t counter = deadlineIn(buttonPressTime);
         bool g = true;
         while (g) {
             if (digitalRead(redButtonPIN)) {
                 g = false;
             }
-            else if (millis() > counter) {
+            else if (deadlineReached(counter)) {
                 noInterrupt = true;
                 switchMode(config);
                 g = false;
@@ -1153,104 +3567,99 @@ void setup() {
         switchMode(standard);
     }
 
-    // -- Configure RTC --
-    // Initialize Clock
-    clock.begin();
-
-    // Set default time in the clock
-    // configureRTC(); removed to save ram
-
-    // -- Configure BME --
-    Wire.begin();
-    BMESensor.begin();
+    // -- Boot --
+    // Every device gets a bounded time to answer, a missing sensor is logged as N/A.
+    // The GPS is started first, so it boots while the other devices are set up
+    unsigned long bootStart = millis();
+    unsigned long phaseStart = bootStart;
 
     // -- Configure GPS --
     // Open SoftwareSerial for GPS
     SoftSerial.begin(9600);
 
-    // Wait until SoftSerial is open
-    while(!SoftSerial.available()) {
-        ;
+    // Only let the GPS send what is used, this also wakes it up if it was left in standby
+    configureGPS();
+
+    // -- Configure RTC --
+    // Initialize Clock, this also starts the I2C bus
+    phaseStart = millis();
+    clock.begin();
+
+#ifdef WIRE_HAS_TIMEOUT
+    // A device holding the I2C bus would otherwise block forever
+    Wire.setWireTimeout(I2Ctimeout, true);
+#endif
+
+    RTCpresent = I2Cpresent(DS1307_I2C_ADDRESS);
+    printBootPhase(F("RTC"), phaseStart, RTCpresent);
+
+    // -- Configure BME --
+    phaseStart = millis();
+    BMEpresent = I2Cpresent(BME280address);
+    if (BMEpresent) {
+        BMESensor.begin();
     }
+    printBootPhase(F("BME"), phaseStart, BMEpresent);
 
     // -- Configure SD Card --
+    phaseStart = millis();
     if (!SD.begin(chipSelect, SPI_HALF_SPEED)){
-        // Stop execution if SD card fails
+        // Stop execution if SD card fails, there is nowhere to log to
         criticalError(SDread_error);
     }
+    printBootPhase(F("SD"), phaseStart, true);
+
+    // -- Wait for the GPS --
+    // It answers the PMTK commands and sends a sentence every GPS_RATE ms once running
+    phaseStart = millis();
+    while (!SoftSerial.available() && millis() - bootStart < currentSystemConfiguration.GPS_RATE + GPSbootTimeout) {
+        ;
+    }
+    GPSpresent = SoftSerial.available();
+    printBootPhase(F("GPS"), phaseStart, GPSpresent);
+
+    printBootPhase(F("Boot"), bootStart, true);
 
     // -- Setup interrupts for buttons --
     // This is done last to prevent interrupts during 'setup()'
     attachInterrupt(digitalPinToInterrupt(greenButtonPIN), greenButtonInterrupt, CHANGE);
     attachInterrupt(digitalPinToInterrupt(redButtonPIN), redButtonInterrupt, CHANGE);
 
-    Serial.println("->");
+    Serial.println(F("->"));
 }
 
 void loop() {
-    if (nextMode == noMode) {
-        switch (currentMode) {
-            case standard:
-                if (millis() > nextMeasureTimer) {
-                    // Set time for next measure
-                    nextMeasureTimer = millis() + currentSystemConfiguration.LOG_INTERVALL * 1000 * 60;
-
-                    // Perform sensor reading
-                    performReading();
-                }
-                break;
-
-            case economic:
-                if (millis() > nextMeasureTimer) {
-                    // Set time for next measure
-                    nextMeasureTimer = millis() + (currentSystemConfiguration.LOG_INTERVALL * 2 * 1000 * 60);
-
-                    // Perform sensor reading
-                    performReading();
-                }
-                break;
-
-            case maintenance:
-                // Close the current file if it is still open
-                if (fileOpen) {
-                    currentFile.close();
-                    fileOpen = false;
-                }
-
-                // Set time for next measure
-                nextMeasureTimer = millis() + currentSystemConfiguration.LOG_INTERVALL * 1000 * 60;
-
-                // Perform sensor reading
-                performReading();
-                break;
+    // Keep the NMEA parser fed, so the latest GGA sentence is ready when a reading is performed
+    pollGPS();
 
-            case config:
-                // Switch modes if 'switchModeTimer' is exceeded
-
-                // Serial.println(switchModeTimer - millis());
-
-                if (millis() > switchModeTimer) {
-                    // Allow interrupts
-                    noInterrupt = false;
-
-                    // Switch mode
-                    switchMode(standard);
-                }
-                // Go into config mode if there is something in Serial
-                else if (Serial.available() > 0) {
-                    configMode();
-                }
-                break;
+    // Serial commands, read only ones in every mode and config commands in config mode
+    pollSerial();
 
-            case noMode:
-                // 'noMode' is not allowed as a system mode, switchMode() will not allow switching to it
-                break;
+    // -- Mode switches --
+    if (nextMode != noMode) {
+        // Show the pending mode on the LED while the button is held
+        if (!taskActive(LED_task)) {
+            startTask(LED_task, 0);
         }
 
+        if (deadlineReached(switchModeTimer)) {
+            greenButtonPressed = false;
+            redButtonPressed = false;
+            switchMode(nextMode);
+        }
     }
-    else if (millis() > switchModeTimer) {
-        greenButtonPressed = false;
-        redButtonPressed = false;
-        switchMode(nextMode);
+    // Switch back to standard mode if 'switchModeTimer' is exceeded in config mode
+    else if (currentMode == config && deadlineReached(switchModeTimer)) {
+        // Allow interrupts
+        noInterrupt = false;
+
+        switchMode(standard);
     }
+
+    // -- Tasks of the current mode --
+    wakeGPSbeforeReading();
+    runDueTasks();
+
+    // Nothing else is due until the next interrupt or deadline
+    sleepUntilNextEvent();
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include <unity.h>
+#include "scheduler.h"
+
+/**
+=================================================== \n
+=================== Scheduler tests =================== \n
+===================================================
+*/
+
+// Run on the computer with 'pio test -e native'. The millisecond counter is simulated,
+// so the deadlines can be checked on both sides of its overflow after 49.7 days
+
+// -- Simulated time source --
+uint32_t simulatedTime;
+
+uint32_t simulatedClock() {
+    return simulatedTime;
+}
+
+timeSource schedulerTime = simulatedClock;
+
+// Time 'offset' ms away from the overflow of the millisecond counter
+uint32_t aroundWrap(int32_t offset) {
+    return (uint32_t)offset;
+}
+
+void setUp() {
+    simulatedTime = 0;
+}
+
+void tearDown() {
+}
+
+void test_deadline_passed() {
+    TEST_ASSERT_FALSE(deadlinePassed(999, 1000));
+    TEST_ASSERT_TRUE(deadlinePassed(1000, 1000));
+    TEST_ASSERT_TRUE(deadlinePassed(1001, 1000));
+}
+
+void test_deadline_passed_across_wrap() {
+    uint32_t deadline = aroundWrap(16);
+
+    TEST_ASSERT_FALSE(deadlinePassed(aroundWrap(-16), deadline));
+    TEST_ASSERT_FALSE(deadlinePassed(aroundWrap(-1), deadline));
+    TEST_ASSERT_FALSE(deadlinePassed(aroundWrap(0), deadline));
+    TEST_ASSERT_TRUE(deadlinePassed(aroundWrap(16), deadline));
+    TEST_ASSERT_TRUE(deadlinePassed(aroundWrap(17), deadline));
+
+    // A deadline just before the overflow has passed once the counter restarted
+    TEST_ASSERT_TRUE(deadlinePassed(aroundWrap(5), aroundWrap(-5)));
+}
+
+void test_deadline_limit() {
+    // Up to 2^31 ms (24.8 days) ahead a deadline is in the future, further away it is taken as passed
+    uint32_t now = aroundWrap(-10);
+    TEST_ASSERT_FALSE(deadlinePassed(now, now + 0x7FFFFFFFUL));
+    TEST_ASSERT_FALSE(deadlinePassed(now, now + 0x80000000UL));
+    TEST_ASSERT_TRUE(deadlinePassed(now, now + 0x80000001UL));
+}
+
+void test_time_until_across_wrap() {
+    TEST_ASSERT_EQUAL_UINT32(32, timeUntil(aroundWrap(-16), aroundWrap(16)));
+    TEST_ASSERT_EQUAL_UINT32(1, timeUntil(aroundWrap(-1), aroundWrap(0)));
+    TEST_ASSERT_EQUAL_UINT32(0, timeUntil(aroundWrap(16), aroundWrap(16)));
+    TEST_ASSERT_EQUAL_UINT32(0, timeUntil(aroundWrap(20), aroundWrap(-20)));
+}
+
+void test_earliest_deadline_across_wrap() {
+    uint32_t now = aroundWrap(-100);
+    uint32_t beforeWrap = aroundWrap(-50);
+    uint32_t afterWrap = aroundWrap(50);
+
+    // Numerically the deadline after the overflow is the smallest one
+    TEST_ASSERT_EQUAL_UINT32(beforeWrap, earliestDeadline(now, beforeWrap, afterWrap));
+    TEST_ASSERT_EQUAL_UINT32(beforeWrap, earliestDeadline(now, afterWrap, beforeWrap));
+
+    // Passed deadlines come first, ties return the first one
+    TEST_ASSERT_EQUAL_UINT32(aroundWrap(-200), earliestDeadline(now, afterWrap, aroundWrap(-200)));
+    TEST_ASSERT_EQUAL_UINT32(afterWrap, earliestDeadline(now, afterWrap, afterWrap));
+}
+
+void test_time_source_across_wrap() {
+    simulatedTime = aroundWrap(-1000);
+    uint32_t deadline = deadlineIn(3000);
+    TEST_ASSERT_EQUAL_UINT32(aroundWrap(2000), deadline);
+    TEST_ASSERT_FALSE(deadlineReached(deadline));
+    TEST_ASSERT_EQUAL_UINT32(3000, timeLeft(deadline));
+
+    // Walk past the overflow by steps of the shortest watchdog period
+    while (!deadlineReached(deadline)) {
+        TEST_ASSERT_TRUE(timeLeft(deadline) > 0);
+        simulatedTime += watchdogPeriod(0);
+    }
+    TEST_ASSERT_TRUE(simulatedTime >= deadline && simulatedTime < deadline + watchdogPeriod(0));
+    TEST_ASSERT_EQUAL_UINT32(0, timeLeft(deadline));
+}
+
+void test_minutes_to_ms() {
+    TEST_ASSERT_EQUAL_UINT32(60000UL, minutesToMs(1));
+    TEST_ASSERT_EQUAL_UINT32(65535UL * 60000UL, minutesToMs(65535));
+}
+
+void test_watchdog_prescaler() {
+    TEST_ASSERT_EQUAL_INT(noWatchdogPeriod, watchdogPrescaler(15));
+    TEST_ASSERT_EQUAL_INT(0, watchdogPrescaler(16));
+    TEST_ASSERT_EQUAL_INT(5, watchdogPrescaler(1000));
+    TEST_ASSERT_EQUAL_INT(watchdogMaxPrescaler, watchdogPrescaler(60000));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_deadline_passed);
+    RUN_TEST(test_deadline_passed_across_wrap);
+    RUN_TEST(test_deadline_limit);
+    RUN_TEST(test_time_until_across_wrap);
+    RUN_TEST(test_earliest_deadline_across_wrap);
+    RUN_TEST(test_time_source_across_wrap);
+    RUN_TEST(test_minutes_to_ms);
+    RUN_TEST(test_watchdog_prescaler);
+    return UNITY_END();
+}
@@ -0,0 +1,224 @@
+#include <unity.h>
+#include <math.h>
+#include "statistics.h"
+
+/**
+=================================================== \n
+=================== Statistics tests =================== \n
+===================================================
+*/
+
+// Run on the computer with 'pio test -e native'. The integer statistics are checked against
+// the mean and sample standard deviation computed in double precision
+
+// -- Pseudo random samples --
+// A fixed linear congruential generator, so every run checks the same samples
+uint32_t randomState;
+
+uint32_t nextRandom() {
+    randomState = randomState * 1664525UL + 1013904223UL;
+    return randomState >> 8;
+}
+
+// Roughly normal sample around 'center', from the sum of 4 uniform ones in [-spread, spread]
+int32_t randomSample(int32_t center, int32_t spread) {
+    int32_t sum = 0;
+    for (unsigned char i = 0; i < 4; i++) {
+        sum += (int32_t)(nextRandom() % (2 * (uint32_t)spread + 1)) - spread;
+    }
+    return center + sum / 2;
+}
+
+// -- Double precision reference --
+struct referenceStatistics {
+    double sum;
+    double squares;
+    uint32_t count;
+};
+
+double referenceMean(const referenceStatistics& reference) {
+    return reference.sum / reference.count;
+}
+
+double referenceDeviation(const referenceStatistics& reference) {
+    double mean = referenceMean(reference);
+    return sqrt((reference.squares - reference.count * mean * mean) / (reference.count - 1));
+}
+
+// Samples of the current check
+int32_t sampleCenter;
+int32_t sampleSpread;
+
+int32_t randomInput(uint16_t) {
+    return randomSample(sampleCenter, sampleSpread);
+}
+
+// Feeds the samples 'input(0)' to 'input(count - 1)' to both and checks that they agree within 1 LSB,
+// 'center' is any value close to them
+void checkInput(int32_t (*input)(uint16_t), uint16_t count, int32_t center) {
+    runningStatistics statistics{};
+    clearStatistics(statistics);
+
+    // The squares are summed around the center, so the reference keeps its precision with large offsets
+    referenceStatistics reference = {0, 0, 0};
+    int32_t minimum = INT32_MAX;
+    int32_t maximum = INT32_MIN;
+
+    for (uint16_t i = 0; i < count; i++) {
+        int32_t sample = input(i);
+        addSample(statistics, sample);
+
+        double offset = sample - center;
+        reference.sum += offset;
+        reference.squares += offset * offset;
+        reference.count++;
+        minimum = sample < minimum ? sample : minimum;
+        maximum = sample > maximum ? sample : maximum;
+    }
+
+    TEST_ASSERT_EQUAL_UINT16(count, statistics.count);
+    TEST_ASSERT_EQUAL_INT32(minimum, statistics.minimum);
+    TEST_ASSERT_EQUAL_INT32(maximum, statistics.maximum);
+    TEST_ASSERT_INT32_WITHIN(1, lround(center + referenceMean(reference)), statisticsMean(statistics));
+    TEST_ASSERT_UINT32_WITHIN(1, lround(referenceDeviation(reference)), statisticsDeviation(statistics));
+}
+
+void checkAgainstReference(int32_t center, int32_t spread, uint16_t count) {
+    sampleCenter = center;
+    sampleSpread = spread;
+    checkInput(randomInput, count, center);
+}
+
+void setUp() {
+    randomState = 1;
+}
+
+void tearDown() {
+}
+
+// Temperature in 1/100 °C, a 10 minute LOG interval sampled every 10 s
+void test_temperature() {
+    checkAgainstReference(2153, 8, 60);
+    checkAgainstReference(-1270, 150, 60);
+}
+
+// Pressure in Pa, the largest values of the channels
+void test_pressure_offset() {
+    checkAgainstReference(101325, 3, 720);
+    checkAgainstReference(101325, 1, 2);
+    checkAgainstReference(110000, 500, 1000);
+}
+
+// Only the offsets from the first sample are summed
+void test_large_offset() {
+    checkAgainstReference(1000000000, 100, 500);
+    checkAgainstReference(-1000000000, 100, 500);
+}
+
+// The longest window
+void test_maximum_count() {
+    checkAgainstReference(101325, 40, statisticsMaxCount);
+    checkAgainstReference(512, 511, statisticsMaxCount);
+}
+
+// Inputs whose running mean would move by less than its resolution at every sample
+int32_t slowDrift(uint16_t i) {
+    return 101325 + i / 100;
+}
+
+int32_t lateStep(uint16_t i) {
+    return i < 700 ? 0 : 1;
+}
+
+int32_t firstSpike(uint16_t i) {
+    return i == 0 ? statisticsMaxOffset : 0;
+}
+
+int32_t lastSpike(uint16_t i) {
+    return i == statisticsMaxCount - 1 ? statisticsMaxOffset : 0;
+}
+
+int32_t sawtooth(uint16_t i) {
+    return i % 3;
+}
+
+void test_slow_changes() {
+    checkInput(slowDrift, statisticsMaxCount, 101325);
+    checkInput(lateStep, statisticsMaxCount, 0);
+    checkInput(firstSpike, statisticsMaxCount, 0);
+    checkInput(lastSpike, statisticsMaxCount, 0);
+    checkInput(sawtooth, statisticsMaxCount, 1);
+}
+
+void test_constant_input() {
+    runningStatistics statistics{};
+    clearStatistics(statistics);
+    for (uint16_t i = 0; i < statisticsMaxCount; i++) {
+        addSample(statistics, 101325);
+    }
+
+    TEST_ASSERT_EQUAL_INT32(101325, statisticsMean(statistics));
+    TEST_ASSERT_EQUAL_UINT32(0, statisticsDeviation(statistics));
+    TEST_ASSERT_EQUAL_INT32(101325, statistics.minimum);
+    TEST_ASSERT_EQUAL_INT32(101325, statistics.maximum);
+}
+
+void test_few_samples() {
+    runningStatistics statistics{};
+    clearStatistics(statistics);
+    addSample(statistics, -7);
+    TEST_ASSERT_EQUAL_INT32(-7, statisticsMean(statistics));
+    TEST_ASSERT_EQUAL_UINT32(0, statisticsDeviation(statistics));
+
+    addSample(statistics, 3);
+    TEST_ASSERT_EQUAL_INT32(-2, statisticsMean(statistics));
+    TEST_ASSERT_EQUAL_UINT32(7, statisticsDeviation(statistics));
+}
+
+// Alternating between the extremes of the offsets gives the largest sum of squares a window can reach,
+// the 32 bit sums must not overflow at 'statisticsMaxCount' samples
+int32_t extremes(uint16_t i) {
+    return i == 0 ? 0 : i % 2 ? statisticsMaxOffset : -statisticsMaxOffset;
+}
+
+void test_largest_sums() {
+    checkInput(extremes, statisticsMaxCount, 0);
+    checkInput(extremes, 2, 0);
+
+    // Further samples are ignored
+    runningStatistics statistics{};
+    clearStatistics(statistics);
+    for (uint16_t i = 0; i <= statisticsMaxCount; i++) {
+        addSample(statistics, i == statisticsMaxCount ? -5000 : 30000 + extremes(i));
+    }
+    TEST_ASSERT_EQUAL_UINT16(statisticsMaxCount, statistics.count);
+    TEST_ASSERT_EQUAL_INT32(30000 - statisticsMaxOffset, statistics.minimum);
+}
+
+// Samples further from the first one than the bound count as the bound, the minimum and maximum are exact
+void test_offset_bound() {
+    runningStatistics statistics{};
+    clearStatistics(statistics);
+    addSample(statistics, 100000);
+    addSample(statistics, 100000 + 3000);
+    addSample(statistics, 100000 - 5000);
+
+    TEST_ASSERT_EQUAL_INT32(100000, statisticsMean(statistics));
+    TEST_ASSERT_EQUAL_UINT32(statisticsMaxOffset, statisticsDeviation(statistics));
+    TEST_ASSERT_EQUAL_INT32(100000 - 5000, statistics.minimum);
+    TEST_ASSERT_EQUAL_INT32(100000 + 3000, statistics.maximum);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_temperature);
+    RUN_TEST(test_pressure_offset);
+    RUN_TEST(test_large_offset);
+    RUN_TEST(test_maximum_count);
+    RUN_TEST(test_slow_changes);
+    RUN_TEST(test_constant_input);
+    RUN_TEST(test_few_samples);
+    RUN_TEST(test_largest_sums);
+    RUN_TEST(test_offset_bound);
+    return UNITY_END();
+}
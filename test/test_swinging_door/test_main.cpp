@@ -0,0 +1,210 @@
+#include <unity.h>
+#include <math.h>
+#include "swingingDoor.h"
+
+/**
+=================================================== \n
+================= Swinging door tests ================= \n
+===================================================
+*/
+
+// Run on the computer with 'pio test -e native'. Pressure traces are compressed the way 'logChanges()' does
+// with DEADBAND, then rebuilt by linear interpolation between the records like 'tools/reconstructLog.py'.
+// The largest error of the rebuilt trace must stay below the deviation plus 1 Pa of rounding
+
+#define maxSamples 2000
+
+// -- Compressed trace --
+struct pressureRecord {
+    uint32_t time;      // In s
+    int32_t pressure;   // In Pa
+};
+
+pressureRecord records[maxSamples];
+uint16_t recordCount;
+
+// Last record and its door
+swingingDoor door;
+
+uint32_t doorRun(uint32_t time) {
+    uint32_t run = time - records[recordCount - 1].time;
+    return run > 0 ? run : 1;
+}
+
+int32_t doorRise(int32_t pressure) {
+    return pressure - records[recordCount - 1].pressure;
+}
+
+// Writes a reading with its pressure moved onto the door, like 'writeLoggedRecord()'
+void writeRecord(uint32_t time, int32_t pressure) {
+    if (recordCount > 0) {
+        pressure = records[recordCount - 1].pressure + riseOnDoor(door, doorRise(pressure), doorRun(time));
+    }
+    records[recordCount].time = time;
+    records[recordCount].pressure = pressure;
+    recordCount++;
+    door.open = false;
+}
+
+// -- Compresses 'count' readings taken every 'period' s --
+// Like 'logChanges()' with only the pressure, a record is written at least every 'maxSilence' s
+void compress(const int32_t* pressures, uint16_t count, uint32_t period, int32_t deviation, uint32_t maxSilence) {
+    recordCount = 0;
+    bool held = false;
+    uint32_t heldTime = 0;
+    int32_t heldPressure = 0;
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t time = i * period;
+        int32_t pressure = pressures[i];
+
+        if (recordCount > 0 && !narrowDoor(door, doorRise(pressure), doorRun(time), deviation)) {
+            if (held) {
+                writeRecord(heldTime, heldPressure);
+            }
+            door.open = false;
+            narrowDoor(door, doorRise(pressure), doorRun(time), deviation);
+        }
+
+        if (recordCount == 0 || time - records[recordCount - 1].time >= maxSilence) {
+            writeRecord(time, pressure);
+            held = false;
+            continue;
+        }
+        held = true;
+        heldTime = time;
+        heldPressure = pressure;
+    }
+
+    // Like 'switchMode()', the trace ends with its last reading
+    if (held) {
+        writeRecord(heldTime, heldPressure);
+    }
+}
+
+// -- Largest difference between the readings and the linear interpolation of the records --
+double largestError(const int32_t* pressures, uint16_t count, uint32_t period) {
+    double largest = 0;
+    uint16_t record = 0;
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t time = i * period;
+        while (record + 2 < recordCount && records[record + 1].time <= time) {
+            record++;
+        }
+
+        const pressureRecord& first = records[record];
+        const pressureRecord& next = records[record + 1 < recordCount ? record + 1 : record];
+        double rebuilt = first.pressure;
+        if (next.time > first.time) {
+            rebuilt += (double)(next.pressure - first.pressure) * ((double)time - first.time) / (next.time - first.time);
+        }
+
+        double error = fabs(rebuilt - pressures[i]);
+        largest = error > largest ? error : largest;
+    }
+    return largest;
+}
+
+// -- Pseudo random noise --
+// A fixed linear congruential generator, so every run checks the same trace
+uint32_t randomState;
+
+int32_t noise(int32_t spread) {
+    int32_t sum = 0;
+    for (unsigned char i = 0; i < 4; i++) {
+        randomState = randomState * 1664525UL + 1013904223UL;
+        sum += (int32_t)((randomState >> 8) % (2 * (uint32_t)spread + 1)) - spread;
+    }
+    return sum / 2;
+}
+
+int32_t pressures[maxSamples];
+
+void setUp() {
+    randomState = 2;
+    recordCount = 0;
+}
+
+void tearDown() {
+}
+
+// Three readings where the line to the last one misses the middle one by more than the deviation.
+// Written as read, the last reading would leave the middle one 12.5 Pa off the line
+void test_line_misses_held_reading() {
+    const int32_t trace[] = {0, 0, 25, -100};
+    compress(trace, 4, 1, 10, 3600);
+
+    TEST_ASSERT_EQUAL_UINT16(3, recordCount);
+    TEST_ASSERT_EQUAL_UINT32(2, records[1].time);
+    TEST_ASSERT_EQUAL_INT32(20, records[1].pressure);
+    TEST_ASSERT_TRUE(largestError(trace, 4, 1) <= 10);
+}
+
+// 2000 readings every 2 minutes of a slow 300 Pa swing with noise, 20 Pa deviation and a record every 3 h
+void test_noisy_swing() {
+    for (uint16_t i = 0; i < maxSamples; i++) {
+        pressures[i] = 101300 + lround(300 * sin(i / 200.0)) + noise(6);
+    }
+    compress(pressures, maxSamples, 120, 20, 3 * 3600UL);
+
+    double error = largestError(pressures, maxSamples, 120);
+    TEST_ASSERT_TRUE(error < 20 + 1);
+    TEST_ASSERT_TRUE(error > 10);
+    TEST_ASSERT_TRUE(recordCount < maxSamples / 20);
+}
+
+// A front : 250 Pa lost within 20 minutes between two calm periods, 5 Pa deviation
+void test_front() {
+    for (uint16_t i = 0; i < 600; i++) {
+        int32_t drop = i < 300 ? 0 : i >= 310 ? 250 : (i - 300) * 25;
+        pressures[i] = 101000 - drop + noise(2);
+    }
+    compress(pressures, 600, 120, 5, 3 * 3600UL);
+
+    TEST_ASSERT_TRUE(largestError(pressures, 600, 120) < 5 + 1);
+}
+
+// Readings that flicker by 1 Pa around a constant, every second, only the record every 1000 s is written
+void test_flicker() {
+    for (uint16_t i = 0; i < maxSamples; i++) {
+        pressures[i] = 100000 + (i % 2 ? 1 : -1);
+    }
+    compress(pressures, maxSamples, 1, 3, 1000);
+
+    TEST_ASSERT_TRUE(largestError(pressures, maxSamples, 1) < 3 + 1);
+    TEST_ASSERT_EQUAL_UINT16(3, recordCount);
+}
+
+// Without deviation every reading that is not on a straight line is written
+void test_no_deviation() {
+    for (uint16_t i = 0; i < 500; i++) {
+        pressures[i] = 100000 + i / 10 + noise(1);
+    }
+    compress(pressures, 500, 60, 0, 3600);
+
+    TEST_ASSERT_TRUE(largestError(pressures, 500, 60) < 1);
+}
+
+// Readings beyond the bounds of the door close it, so each one is written as read
+void test_beyond_bounds() {
+    const int32_t steps[] = {100000, 100000, 80000, 80000, 100000, 100010};
+    compress(steps, 6, 60, 20, 3600);
+    TEST_ASSERT_TRUE(largestError(steps, 6, 60) < 20 + 1);
+
+    const int32_t slow[] = {100000, 100001, 100000, 100002};
+    compress(slow, 4, doorMaxRun + 1, 20, 4 * (doorMaxRun + 1UL));
+    TEST_ASSERT_EQUAL_UINT16(4, recordCount);
+    TEST_ASSERT_TRUE(largestError(slow, 4, doorMaxRun + 1) < 1);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_line_misses_held_reading);
+    RUN_TEST(test_noisy_swing);
+    RUN_TEST(test_front);
+    RUN_TEST(test_flicker);
+    RUN_TEST(test_no_deviation);
+    RUN_TEST(test_beyond_bounds);
+    return UNITY_END();
+}
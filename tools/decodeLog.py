@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""
+Decodes binary LOG files (*.BIN) written by the WorldWideWeatherWatcher
+when LOG_FORMAT is set to 1, and prints one text line per record.
+
+The record layout must be kept in sync with 'struct logRecord' and
+'struct statisticsRecord' in src/main.cpp.
+
+Usage : decodeLog.py FILE [FILE ...]
+"""
+
+import struct
+import sys
+from datetime import datetime, timedelta
+
+# -- logRecord layout (packed, little endian as on the AVR) --
+RECORD = struct.Struct("<IhHIHBBIiiiHBBH")
+
+# -- statisticsRecord layout, follows a record flagged STATISTICS_RECORD --
+# minimum, maximum, deviation and count of temperature, humidity, pressure and light
+STATISTICS = struct.Struct("<" + "iiHH" * 4)
+
+# -- Validity bits of logRecord.valid --
+RTC_VALID = 1
+GPS_VALID = 2
+LIGHT_VALID = 4
+TEMPERATURE_VALID = 8
+HUMIDITY_VALID = 16
+PRESSURE_VALID = 32
+RATE_CHANGED = 64
+STATISTICS_RECORD = 128
+
+LIGHT_CLASSES = ("LOW", "AVG", "HIGH")
+EPOCH = datetime(2000, 1, 1)
+SEPARATOR = " ; "
+
+
+def format_summary(summary, scale):
+    """Summary of a channel over a LOG interval, as in the text LOG files"""
+    minimum, maximum, deviation, count = summary
+    if scale == 1:
+        return " (%d..%d sd %d n %d)" % (minimum, maximum, deviation, count)
+    return " (%.2f..%.2f sd %.2f n %d)" % (minimum / scale, maximum / scale, deviation / scale, count)
+
+
+def format_record(fields, statistics=None):
+    (timestamp, temperature, humidity, pressure, light, light_class, valid,
+     gps_time, latitude, longitude, altitude, hdop, quality, satellites, position_age) = fields
+    values = []
+
+    # Mean values, each followed by the summary of its channel
+    summaries = {}
+    if statistics is not None:
+        for index, channel in enumerate(("temperature", "humidity", "pressure", "light")):
+            summaries[channel] = statistics[4 * index:4 * index + 4]
+
+    # Same layout as the text LOG files, the GPS UTC time is only part of the binary record
+    # Like the firmware, the age of the fix is only shown from 2 s on
+    if valid & GPS_VALID:
+        position = "%.6f %.6f %.2fm %dsat H%.2f" % (latitude / 1e6, longitude / 1e6, altitude / 100, satellites, hdop / 100)
+        if position_age >= 2:
+            position += " (%ds)" % position_age
+        values.append(position)
+    else:
+        values.append("N/A")
+
+    if valid & RTC_VALID:
+        values.append((EPOCH + timedelta(seconds=timestamp)).strftime("%H:%M:%S-%m/%d/%Y"))
+    else:
+        values.append("N/A")
+
+    if valid & LIGHT_VALID:
+        value = "%s (%d)" % (LIGHT_CLASSES[light_class] if light_class < 3 else "?", light)
+        if summaries:
+            value += format_summary(summaries["light"], 1)
+        values.append(value)
+    for flag, channel, reading in ((TEMPERATURE_VALID, "temperature", temperature),
+                                   (HUMIDITY_VALID, "humidity", humidity),
+                                   (PRESSURE_VALID, "pressure", pressure)):
+        if valid & flag:
+            value = "%.2f" % (reading / 100)
+            if summaries:
+                value += format_summary(summaries[channel], 100)
+            values.append(value)
+
+    # First record after the LOG interval was adapted to the pressure tendency,
+    # the new interval shows in the timestamps of the following records
+    if valid & RATE_CHANGED:
+        values.append("RATE CHANGE")
+
+    return SEPARATOR.join(values)
+
+
+def read_records(path):
+    """Yields the (fields, statistics) of every record of a binary LOG file, statistics is None without STATISTICS"""
+    with open(path, "rb") as file:
+        data = file.read()
+
+    # Records are 38 bytes, or 86 with their statistics
+    offset = 0
+    while offset + RECORD.size <= len(data):
+        # A preallocated file that was not closed ends with its erased extent
+        raw = data[offset:offset + RECORD.size]
+        if raw.count(0) == len(raw) or raw.count(0xFF) == len(raw):
+            break
+
+        fields = RECORD.unpack_from(data, offset)
+        size = RECORD.size
+        statistics = None
+
+        if fields[6] & STATISTICS_RECORD:
+            if offset + size + STATISTICS.size > len(data):
+                break
+            statistics = STATISTICS.unpack_from(data, offset + size)
+            size += STATISTICS.size
+
+        yield fields, statistics
+        offset += size
+
+    if offset != len(data) and data[offset:].strip(b"\x00\xff"):
+        print("%s : %d trailing bytes ignored" % (path, len(data) - offset), file=sys.stderr)
+
+
+def decode(path):
+    for fields, statistics in read_records(path):
+        print(format_record(fields, statistics))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print(__doc__.strip(), file=sys.stderr)
+        sys.exit(1)
+
+    for argument in sys.argv[1:]:
+        decode(argument)
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""
+Rebuilds regularly spaced readings from binary LOG files (*.BIN) written
+with DEADBAND=1, where a record is only written once a channel changed.
+
+Between two records, the pressure is interpolated linearly. The swinging
+door compression on the station writes each record's pressure on a line
+from the previous record that passes within DEADBAND_PRESS of every reading
+in between, so the interpolated pressure is off by at most DEADBAND_PRESS
+plus 1 Pa of rounding. A record's own pressure may differ from its reading
+by up to DEADBAND_PRESS. Temperature, humidity and luminosity keep the value of the
+previous record, which every reading in between was within DEADBAND_ of.
+Files written without DEADBAND are simply resampled.
+
+Prints one CSV line every STEP seconds, from the first to the last record
+with an RTC time. A channel is empty where it was not valid.
+
+Usage : reconstructLog.py STEP FILE [FILE ...]
+"""
+
+import sys
+from datetime import timedelta
+
+from decodeLog import (EPOCH, RTC_VALID, LIGHT_VALID, TEMPERATURE_VALID,
+                       HUMIDITY_VALID, PRESSURE_VALID, read_records)
+
+
+def load(paths):
+    """(timestamp, valid, temperature, humidity, pressure, light) of the records with an RTC time, in time order"""
+    records = []
+    for path in paths:
+        for fields, _ in read_records(path):
+            timestamp, temperature, humidity, pressure, light, _, valid = fields[:7]
+            if valid & RTC_VALID:
+                records.append((timestamp, valid, temperature, humidity, pressure, light))
+    records.sort(key=lambda record: record[0])
+    return records
+
+
+def held(record, flag, value, scale):
+    """Value of the previous record, as the firmware held it back within its deadband"""
+    return "%.2f" % (value / scale) if record[1] & flag else ""
+
+
+def interpolated(before, after, time):
+    """Pressure on the line between two records, in hPa"""
+    if not (before[1] & PRESSURE_VALID):
+        return ""
+    if after is None or not (after[1] & PRESSURE_VALID) or after[0] == before[0]:
+        return "%.2f" % (before[4] / 100)
+
+    fraction = (time - before[0]) / (after[0] - before[0])
+    return "%.2f" % ((before[4] + fraction * (after[4] - before[4])) / 100)
+
+
+def reconstruct(step, records):
+    print("time,temperature,humidity,pressure,light")
+    if not records:
+        return
+
+    index = 0
+    time = records[0][0]
+    while time <= records[-1][0]:
+        while index + 1 < len(records) and records[index + 1][0] <= time:
+            index += 1
+        before = records[index]
+        after = records[index + 1] if index + 1 < len(records) else None
+
+        values = [
+            (EPOCH + timedelta(seconds=time)).strftime("%Y-%m-%d %H:%M:%S"),
+            held(before, TEMPERATURE_VALID, before[2], 100),
+            held(before, HUMIDITY_VALID, before[3], 100),
+            interpolated(before, after, time),
+            "%d" % before[5] if before[1] & LIGHT_VALID else "",
+        ]
+        print(",".join(values))
+        time += step
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 3 or not sys.argv[1].isdigit() or int(sys.argv[1]) == 0:
+        print(__doc__.strip(), file=sys.stderr)
+        sys.exit(1)
+
+    reconstruct(int(sys.argv[1]), load(sys.argv[2:]))